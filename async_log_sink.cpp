@@ -0,0 +1,110 @@
+#include "async_log_sink.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+// how long the drain thread sleeps when the ring is empty
+static const ::std::chrono::milliseconds DRAIN_INTERVAL(5);
+
+AsyncLogSink::AsyncLogSink()
+	: head_(0), tail_(0), dropped_(0), running_(false), file_(nullptr)
+{
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+	close();
+}
+
+bool AsyncLogSink::open(const ::std::string& path)
+{
+	close();
+
+	file_ = (path == "-") ? stderr : fopen(path.c_str(), "a");
+	if(file_ == nullptr)
+		return false;
+
+	slots_.reset(new Slot[NUM_SLOTS]);
+	head_.store(0);
+	tail_.store(0);
+	running_.store(true);
+	thread_ = ::std::thread(&AsyncLogSink::drain, this);
+	return true;
+}
+
+bool AsyncLogSink::isOpen() const
+{
+	return file_ != nullptr;
+}
+
+bool AsyncLogSink::write(const char* line, ::std::size_t length)
+{
+	const uint64_t head = head_.load(::std::memory_order_relaxed);
+	if(head - tail_.load(::std::memory_order_acquire) >= NUM_SLOTS)
+	{
+		dropped_.fetch_add(1, ::std::memory_order_relaxed);
+		return false;
+	}
+
+	Slot& slot = slots_[head & (NUM_SLOTS - 1)];
+	slot.length_ = static_cast<uint32_t>(::std::min<::std::size_t>(length, LINE_SIZE - 1));
+	memcpy(slot.text_, line, slot.length_);
+	slot.text_[slot.length_++] = '\n';
+
+	head_.store(head + 1, ::std::memory_order_release);
+	return true;
+}
+
+/*-------------------------------------------------------------------
+ * Function: drain [drain thread]
+ *-------------------------------------------------------------------*/
+void AsyncLogSink::drain()
+{
+	for(;;)
+	{
+		// read running_ first, so the last batch is drained after close()
+		const bool running = running_.load(::std::memory_order_acquire);
+		const uint64_t head = head_.load(::std::memory_order_acquire);
+		uint64_t tail = tail_.load(::std::memory_order_relaxed);
+
+		if(tail == head)
+		{
+			if(!running)
+				return;
+			::std::this_thread::sleep_for(DRAIN_INTERVAL);
+			continue;
+		}
+
+		for(; tail != head; ++tail)
+		{
+			const Slot& slot = slots_[tail & (NUM_SLOTS - 1)];
+			fwrite(slot.text_, 1, slot.length_, file_);
+		}
+		tail_.store(tail, ::std::memory_order_release);
+		fflush(file_);
+	}
+}
+
+void AsyncLogSink::close()
+{
+	if(file_ == nullptr)
+		return;
+
+	running_.store(false, ::std::memory_order_release);
+	if(thread_.joinable())
+		thread_.join();
+
+	if(file_ != stderr)
+		fclose(file_);
+	file_ = nullptr;
+}
+
+::std::string AsyncLogSink::toString() const
+{
+	::std::ostringstream out;
+	out << "AsyncLogSink {written: " << head_.load()
+		<< ", dropped: " << dropped_.load() << " }";
+	return out.str();
+}
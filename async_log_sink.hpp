@@ -0,0 +1,77 @@
+#ifndef ASYNC_LOG_SINK_HPP
+#define ASYNC_LOG_SINK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+/*-----------------------------------------------
+ * Class: AsyncLogSink
+ * - single producer, single consumer ring of fixed size log lines.
+ * - write() (the event thread) copies the line into the next slot and
+ *   publishes it with one atomic store: no locks, no allocation, no
+ *   system calls. If the ring is full the line is dropped and counted,
+ *   the event loop never waits on the disk.
+ * - a background thread drains the ring to the file.
+ *-----------------------------------------------*/
+class AsyncLogSink
+{
+public:
+	static const unsigned int NUM_SLOTS = 4096;		// power of two
+	static const unsigned int LINE_SIZE = 320;
+
+	AsyncLogSink();
+	~AsyncLogSink();
+
+	/** Function: open
+	 * - appends to path ("-" is stderr) and starts the drain thread.
+	 **/
+	bool open(const ::std::string& path);
+	bool isOpen() const;
+
+	/** Function: write
+	 * - queues line (truncated to LINE_SIZE), a newline is added.
+	 *   false if the ring was full and the line was dropped.
+	 **/
+	bool write(const char* line, ::std::size_t length);
+
+	/** Function: close
+	 * - drains what is queued and stops the thread.
+	 **/
+	void close();
+
+	::std::string toString() const;
+
+private:
+	struct Slot
+	{
+		uint32_t length_;
+		char text_[LINE_SIZE];
+	};
+
+	void drain();
+
+	::std::unique_ptr<Slot[]> slots_;
+	/**
+	 * head_ is only written by write(), tail_ only by the drain thread.
+	 * Padded apart so they don't share a cache line; padding rather than
+	 * alignas, which would make every owner over-aligned (C++14 new does
+	 * not honour that). **/
+	char pad0_[64];
+	::std::atomic<uint64_t> head_;
+	char pad1_[64 - sizeof(::std::atomic<uint64_t>)];
+	::std::atomic<uint64_t> tail_;
+	char pad2_[64 - sizeof(::std::atomic<uint64_t>)];
+	::std::atomic<uint64_t> dropped_;
+	char pad3_[64 - sizeof(::std::atomic<uint64_t>)];
+	::std::atomic<bool> running_;
+
+	FILE* file_;
+	::std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#!/bin/bash
+# Headless interactive latency benchmark.
+#   ./bench.sh [num_clients] [drag_steps] > bench.csv
+# BENCH_CONFIGURES sets the size of the ConfigureRequest burst.
+# BENCH_XSERVER=Xephyr to use Xephyr instead of Xvfb,
+# BENCH_DISPLAY to pick the private display number.
+
+BENCH_XSERVER=${BENCH_XSERVER:-Xvfb}
+BENCH_DISPLAY=${BENCH_DISPLAY:-:99}
+
+if [ "$BENCH_XSERVER" = "Xephyr" ]; then
+	Xephyr -br -ac -noreset -screen 1280x1024 $BENCH_DISPLAY &
+else
+	Xvfb $BENCH_DISPLAY -screen 0 1280x1024x24 -nolisten tcp &
+fi
+XSERVER_PID=$!
+trap 'kill $WM_PID $XSERVER_PID 2>/dev/null' EXIT
+
+# wait for the server socket to appear
+for i in $(seq 50); do
+	[ -S /tmp/.X11-unix/X${BENCH_DISPLAY#:} ] && break
+	sleep 0.1s
+done
+
+mkdir -p glog
+DISPLAY=$BENCH_DISPLAY ./basic_wm &
+WM_PID=$!
+sleep 1s
+
+DISPLAY=$BENCH_DISPLAY ./swim_bench ${1:-20} ${2:-100} ${BENCH_CONFIGURES:-10000}
@@ -0,0 +1,30 @@
+#ifndef CLIENT_HANDLE_HPP
+#define CLIENT_HANDLE_HPP
+
+#include <cstdint>
+
+/*-----------------------------------------------
+ * Struct: ClientHandle
+ * - stable reference to a client in the XLib_ClientRegistry.
+ * - the generation makes a handle to a destroyed client (whose slot
+ *   has since been reused) resolve to nullptr instead of the new client.
+ *-----------------------------------------------*/
+struct ClientHandle
+{
+	uint32_t index_;
+	uint32_t generation_;
+
+	bool operator == (const ClientHandle& other) const
+	{
+		return index_ == other.index_ && generation_ == other.generation_;
+	}
+	bool operator != (const ClientHandle& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+// refers to no client (e.g. an empty XLib_MruList end)
+static const ClientHandle NO_CLIENT = { UINT32_MAX, UINT32_MAX };
+
+#endif
@@ -0,0 +1,117 @@
+#include "client_throttle.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+// idle clients are forgotten at most this often
+static const uint64_t PRUNE_INTERVAL_NS = 10000000000ull; // 10 s
+
+ClientThrottle::ClientThrottle()
+	: resource_mask_(0),
+	  last_prune_ns_(0)
+{
+	memset(limits_, 0, sizeof(limits_));
+	memset(admitted_, 0, sizeof(admitted_));
+	memset(refused_, 0, sizeof(refused_));
+}
+
+void ClientThrottle::setResourceMask(XID mask)
+{
+	resource_mask_ = mask;
+}
+
+XID ClientThrottle::clientOf(Window w) const
+{
+	return w & ~resource_mask_;
+}
+
+double ClientThrottle::burst(Kind kind) const
+{
+	return ::std::max(limits_[kind].burst_, 1u);
+}
+
+/*-------------------------------------------------------------------
+ * Function: admit
+ * - a client's bucket starts full, so a well behaved client (one that
+ *   stays within burst_) is never throttled.
+ *-------------------------------------------------------------------*/
+bool ClientThrottle::admit(Kind kind, Window w, uint64_t now_ns, uint64_t& ready_ns)
+{
+	const Limit& limit = limits_[kind];
+	if(limit.rate_ == 0)
+	{
+		++admitted_[kind];
+		return true;
+	}
+
+	if(now_ns - last_prune_ns_ > PRUNE_INTERVAL_NS)
+		prune(now_ns);
+
+	auto inserted = clients_.emplace(clientOf(w), Client());
+	Client& client = inserted.first->second;
+	if(inserted.second)
+	{
+		for(int k = 0; k < NUM_KINDS; ++k)
+			client.buckets_[k] = Bucket{ burst(static_cast<Kind>(k)), now_ns };
+	}
+
+	Bucket& bucket = client.buckets_[kind];
+	bucket.tokens_ = ::std::min(burst(kind), bucket.tokens_ + (now_ns - bucket.last_ns_) * 1e-9 * limit.rate_);
+	bucket.last_ns_ = now_ns;
+
+	if(bucket.tokens_ >= 1.0)
+	{
+		bucket.tokens_ -= 1.0;
+		++admitted_[kind];
+		return true;
+	}
+
+	ready_ns = now_ns + static_cast<uint64_t>((1.0 - bucket.tokens_) * 1e9 / limit.rate_) + 1;
+	++refused_[kind];
+	return false;
+}
+
+/*-------------------------------------------------------------------
+ * Function: prune
+ * - drops clients whose buckets have all refilled; they would start
+ *   full again anyway. Keeps clients_ from growing with every
+ *   connection ever seen.
+ *-------------------------------------------------------------------*/
+void ClientThrottle::prune(uint64_t now_ns)
+{
+	last_prune_ns_ = now_ns;
+	for(auto it = clients_.begin(); it != clients_.end();)
+	{
+		bool idle = true;
+		for(int kind = 0; kind < NUM_KINDS; ++kind)
+		{
+			const Limit& limit = limits_[kind];
+			const Bucket& bucket = it->second.buckets_[kind];
+			if(limit.rate_ && 
+				bucket.tokens_ + (now_ns - bucket.last_ns_) * 1e-9 * limit.rate_ < burst(static_cast<Kind>(kind)))
+				idle = false;
+		}
+		it = idle ? clients_.erase(it) : ::std::next(it);
+	}
+}
+
+::std::string ClientThrottle::toString() const
+{
+	static const char* names[NUM_KINDS] = { "configure", "map" };
+
+	::std::ostringstream out;
+	out << "ClientThrottle {clients: " << clients_.size();
+	for(int kind = 0; kind < NUM_KINDS; ++kind)
+	{
+		out << ", " << names[kind] << " {";
+		if(limits_[kind].rate_)
+			out << "rate: " << limits_[kind].rate_ << "/s, burst: " << limits_[kind].burst_;
+		else
+			out << "unlimited";
+		out << ", admitted: " << admitted_[kind]
+			<< ", refused: " << refused_[kind] << "}";
+	}
+	out << " }";
+	return out.str();
+}
@@ -0,0 +1,82 @@
+#ifndef CLIENT_THROTTLE_HPP
+#define CLIENT_THROTTLE_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/*-----------------------------------------------
+ * Class: ClientThrottle
+ * - token buckets per X client and kind of request, so one runaway
+ *   client cannot make its requests dominate the event loop.
+ * - a client is the connection that created the window: the window id
+ *   without the server's resource id mask. That also covers windows
+ *   that are not managed yet (MapRequest, ConfigureRequest before map).
+ * - the throttle only says "not now"; the WM keeps what was refused
+ *   (merged, last value wins) and asks again once it is ready.
+ *-----------------------------------------------*/
+class ClientThrottle
+{
+public:
+	enum Kind
+	{
+		Configure,
+		Map,
+		NUM_KINDS
+	};
+
+	/**
+	 * rate_ tokens per second, at most burst_ saved up; a rate_ of 0
+	 * admits everything of that kind. **/
+	struct Limit
+	{
+		unsigned int rate_;
+		unsigned int burst_;
+	};
+
+	Limit limits_[NUM_KINDS];
+
+	ClientThrottle();
+
+	/** Function: setResourceMask
+	 * - the server's resource id mask (from the connection setup).
+	 **/
+	void setResourceMask(XID mask);
+	XID clientOf(Window w) const;
+
+	/** Function: admit
+	 * - takes a token of kind from w's client. false if it has none
+	 *   left, then ready_ns receives when the next one is due.
+	 **/
+	bool admit(Kind kind, Window w, uint64_t now_ns, uint64_t& ready_ns);
+
+	::std::string toString() const;
+
+private:
+	struct Bucket
+	{
+		double tokens_;
+		uint64_t last_ns_;
+	};
+
+	struct Client
+	{
+		Bucket buckets_[NUM_KINDS];
+	};
+
+	double burst(Kind kind) const;
+	void prune(uint64_t now_ns);
+
+	XID resource_mask_;
+	::std::unordered_map<XID, Client> clients_;
+	uint64_t last_prune_ns_;
+
+	uint64_t admitted_[NUM_KINDS];
+	uint64_t refused_[NUM_KINDS];
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "config.hpp"
+#include <cstdlib>
+#include <sstream>
+
+/*-------------------------------------------------------------------
+ * Function: envUnsigned
+ * - value of an unsigned environment variable, fallback if unset or
+ *   not a number.
+ *-------------------------------------------------------------------*/
+static unsigned int envUnsigned(const char* name, unsigned int fallback)
+{
+	const char* value = getenv(name);
+	if(value == nullptr || *value == '\0')
+		return fallback;
+
+	char* end;
+	const unsigned long parsed = strtoul(value, &end, 10);
+	return (*end == '\0') ? static_cast<unsigned int>(parsed) : fallback;
+}
+
+/*-------------------------------------------------------------------
+ * Function: envString
+ * - value of a string environment variable, fallback if unset.
+ *-------------------------------------------------------------------*/
+static ::std::string envString(const char* name, const ::std::string& fallback)
+{
+	const char* value = getenv(name);
+	return value ? ::std::string(value) : fallback;
+}
+
+Config Config::FromEnvironment()
+{
+	Config config;
+	config.drag_refresh_hz_ = envUnsigned("SWIM_DRAG_HZ", config.drag_refresh_hz_);
+	config.decoration_pool_size_ = envUnsigned("SWIM_DECORATION_POOL", config.decoration_pool_size_);
+	config.single_window_decorations_ = 
+		envUnsigned("SWIM_SINGLE_WINDOW_DECORATIONS", config.single_window_decorations_) != 0;
+	config.drag_outline_ = envUnsigned("SWIM_DRAG_OUTLINE", config.drag_outline_) != 0;
+	config.input_budget_ = envUnsigned("SWIM_INPUT_BUDGET", config.input_budget_);
+	config.client_budget_ = envUnsigned("SWIM_CLIENT_BUDGET", config.client_budget_);
+	config.configure_rate_ = envUnsigned("SWIM_CONFIGURE_RATE", config.configure_rate_);
+	config.configure_burst_ = envUnsigned("SWIM_CONFIGURE_BURST", config.configure_burst_);
+	config.map_rate_ = envUnsigned("SWIM_MAP_RATE", config.map_rate_);
+	config.map_burst_ = envUnsigned("SWIM_MAP_BURST", config.map_burst_);
+	config.trace_path_ = envString("SWIM_TRACE", config.trace_path_);
+	config.event_log_path_ = envString("SWIM_EVENT_LOG", config.event_log_path_);
+	config.span_trace_prefix_ = envString("SWIM_SPAN_TRACE", config.span_trace_prefix_);
+	return config;
+}
+
+::std::string Config::toString() const
+{
+	::std::ostringstream out;
+	out << "Config {drag_refresh_hz: " << drag_refresh_hz_
+		<< ", decoration_pool_size: " << decoration_pool_size_
+		<< ", single_window_decorations: " << single_window_decorations_
+		<< ", drag_outline: " << drag_outline_
+		<< ", input_budget: " << input_budget_
+		<< ", client_budget: " << client_budget_
+		<< ", configure_rate: " << configure_rate_
+		<< ", configure_burst: " << configure_burst_
+		<< ", map_rate: " << map_rate_
+		<< ", map_burst: " << map_burst_
+		<< ", trace_path: \"" << trace_path_ << "\""
+		<< ", event_log_path: \"" << event_log_path_ << "\""
+		<< ", span_trace_prefix: \"" << span_trace_prefix_ << "\" }";
+	return out.str();
+}
@@ -0,0 +1,64 @@
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <string>
+
+/*-----------------------------------------------
+ * Struct: Config
+ * - runtime settings of the window manager, read from SWIM_*
+ *   environment variables (see FromEnvironment).
+ *-----------------------------------------------*/
+struct Config
+{
+	/** SWIM_DRAG_HZ
+	 * - rate at which a drag applies geometry to the server,
+	 *   0 applies every motion event. **/
+	unsigned int drag_refresh_hz_ = 60;
+	/** SWIM_DECORATION_POOL
+	 * - unmapped decoration sets kept for reuse after clients close,
+	 *   0 disables the pool. **/
+	unsigned int decoration_pool_size_ = 8;
+	/** SWIM_SINGLE_WINDOW_DECORATIONS
+	 * - non zero paints the buttons into the border window and hit
+	 *   tests clicks, instead of giving each button its own window. **/
+	bool single_window_decorations_ = false;
+	/** SWIM_DRAG_OUTLINE
+	 * - non zero drags only an outline of the window, which is moved/
+	 *   resized once when the button is released. **/
+	bool drag_outline_ = false;
+	/** SWIM_INPUT_BUDGET
+	 * - input events dispatched in a row before a waiting client event
+	 *   gets a turn (see EventScheduler). **/
+	unsigned int input_budget_ = 64;
+	/** SWIM_CLIENT_BUDGET
+	 * - client events dispatched per batch, the rest wait for the next
+	 *   batch (and the input that arrives meanwhile). **/
+	unsigned int client_budget_ = 256;
+	/** SWIM_CONFIGURE_RATE / SWIM_CONFIGURE_BURST
+	 * - configures granted per second to one client, and how many it
+	 *   may save up. Held back requests are merged and granted later.
+	 *   A rate of 0 does not throttle. **/
+	unsigned int configure_rate_ = 120;
+	unsigned int configure_burst_ = 30;
+	/** SWIM_MAP_RATE / SWIM_MAP_BURST
+	 * - the same for MapRequests (framing a window). **/
+	unsigned int map_rate_ = 20;
+	unsigned int map_burst_ = 10;
+	/** SWIM_TRACE
+	 * - path of a binary event trace to record (see event_trace.hpp and
+	 *   swim_replay), empty records nothing. **/
+	::std::string trace_path_;
+	/** SWIM_EVENT_LOG
+	 * - file every event is logged to as text ("-" for stderr), off the
+	 *   event thread (see AsyncLogSink). Empty logs nothing. **/
+	::std::string event_log_path_;
+	/** SWIM_SPAN_TRACE
+	 * - path prefix of the Chrome trace files SIGUSR2 writes. **/
+	::std::string span_trace_prefix_ = "swim-spans";
+
+	static Config FromEnvironment();
+
+	::std::string toString() const;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "drag_engine.hpp"
+
+void DragEngine::setRefreshRate(unsigned int hz)
+{
+	interval_ns_ = hz ? 1000000000ull / hz : 0;
+}
+
+void DragEngine::begin(ClientHandle handle, WindowRole role, const Position<int>& pointer,
+	const Position<int>& frame_pos, const Size<int>& frame_size)
+{
+	active_ = true;
+	handle_ = handle;
+	role_ = role;
+	start_pointer_ = pointer;
+	start_frame_pos_ = frame_pos;
+	start_frame_size_ = frame_size;
+	pointer_ = pointer;
+	pending_ = false;
+	last_apply_ns_ = 0;
+	sync_waiting_ = false;
+}
+
+void DragEngine::motion(const Position<int>& pointer)
+{
+	pointer_ = pointer;
+	pending_ = true;
+}
+
+void DragEngine::end()
+{
+	active_ = false;
+	pending_ = false;
+	sync_waiting_ = false;
+}
+
+bool DragEngine::due(uint64_t now_ns) const
+{
+	return active_ && pending_ && now_ns >= deadline();
+}
+
+uint64_t DragEngine::deadline() const
+{
+	const uint64_t paced = last_apply_ns_ + interval_ns_;
+	return sync_waiting_ ? ::std::max(paced, sync_deadline_ns_) : paced;
+}
+
+void DragEngine::applied(uint64_t now_ns)
+{
+	pending_ = false;
+	last_apply_ns_ = now_ns;
+}
+
+void DragEngine::waitForSync(uint64_t now_ns)
+{
+	sync_waiting_ = true;
+	sync_deadline_ns_ = now_ns + sync_timeout_ns_;
+}
+
+void DragEngine::synced()
+{
+	sync_waiting_ = false;
+}
+
+Position<int> DragEngine::targetPosition() const
+{
+	return start_frame_pos_ + (pointer_ - start_pointer_);
+}
+
+Size<int> DragEngine::targetSize() const
+{
+	const Vector2D<int> delta = pointer_ - start_pointer_;
+	const Vector2D<int> size_delta(
+		::std::max(delta.x, -start_frame_size_.width),
+		::std::max(delta.y, -start_frame_size_.height));
+	return start_frame_size_ + size_delta;
+}
@@ -0,0 +1,76 @@
+#ifndef DRAG_ENGINE_HPP
+#define DRAG_ENGINE_HPP
+
+#include <cstdint>
+
+#include "util.hpp"
+#include "xlib_client_registry.hpp"
+#include "xlib_window_index.hpp"
+
+/*-----------------------------------------------
+ * Class: DragEngine
+ * - state of the move/resize drag in progress.
+ * - motion only records the latest pointer position; the geometry it
+ *   implies is applied at most once per refresh interval, by whichever
+ *   comes first of the next motion event or the event loop's timer.
+ * - a resize of a client speaking _NET_WM_SYNC_REQUEST is also held
+ *   back until the client has drawn the previous size.
+ *-----------------------------------------------*/
+class DragEngine
+{
+public:
+	bool active_ = false;
+	ClientHandle handle_;
+	WindowRole role_;			// MoveButton or ResizeButton
+
+	Position<int> start_pointer_;
+	Position<int> start_frame_pos_;
+	Size<int> start_frame_size_;
+
+	Position<int> pointer_;		// latest pointer position seen
+	bool pending_ = false;		// pointer_ not applied yet
+
+	uint64_t interval_ns_ = 0;
+	uint64_t last_apply_ns_ = 0;
+
+	/**
+	 * _NET_WM_SYNC_REQUEST resize: after a synced resize nothing more is
+	 * applied until the client has repainted (synced()), or the timeout
+	 * passes for a client that never answers. **/
+	bool sync_waiting_ = false;
+	uint64_t sync_deadline_ns_ = 0;
+	uint64_t sync_timeout_ns_ = 100000000; // 100 ms
+
+	/** Function: setRefreshRate
+	 * - 0 Hz disables pacing (every motion is applied).
+	 **/
+	void setRefreshRate(unsigned int hz);
+
+	void begin(ClientHandle handle, WindowRole role, const Position<int>& pointer,
+		const Position<int>& frame_pos, const Size<int>& frame_size);
+	void motion(const Position<int>& pointer);
+	void end();
+
+	/** Function: due
+	 * - true if there is pending motion and the interval has passed.
+	 **/
+	bool due(uint64_t now_ns) const;
+	/** Function: deadline
+	 * - when the pending motion becomes due (only meaningful if pending_).
+	 **/
+	uint64_t deadline() const;
+	/** Function: applied
+	 * - marks the pending motion as sent to the server.
+	 **/
+	void applied(uint64_t now_ns);
+	/** Function: waitForSync / synced
+	 * - holds back the next apply until the client has caught up.
+	 **/
+	void waitForSync(uint64_t now_ns);
+	void synced();
+
+	Position<int> targetPosition() const;
+	Size<int> targetSize() const;
+};
+
+#endif
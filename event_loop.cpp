@@ -0,0 +1,126 @@
+#include "event_loop.hpp"
+#include "event_stats.hpp"
+
+#include <cerrno>
+
+/*-------------------------------------------------------------------
+ * Timers
+ *-------------------------------------------------------------------*/
+EventLoop::TimerId EventLoop::addTimer(TimerCallback callback)
+{
+	timers_.push_back(Timer{ false, 0, callback });
+	return timers_.size() - 1;
+}
+
+void EventLoop::armTimer(TimerId id, uint64_t deadline_ns)
+{
+	timers_[id].armed_ = true;
+	timers_[id].deadline_ns_ = deadline_ns;
+}
+
+void EventLoop::disarmTimer(TimerId id)
+{
+	timers_[id].armed_ = false;
+}
+
+bool EventLoop::armed(TimerId id) const
+{
+	return timers_[id].armed_;
+}
+
+void EventLoop::runTimers(uint64_t now_ns)
+{
+	// by index, a callback may add timers
+	for(::std::size_t i = 0; i < timers_.size(); ++i)
+	{
+		if(!timers_[i].armed_ || timers_[i].deadline_ns_ > now_ns)
+			continue;
+		// disarmed first, the callback may re-arm it
+		timers_[i].armed_ = false;
+		TimerCallback callback = timers_[i].callback_;
+		callback(now_ns);
+	}
+}
+
+/*-------------------------------------------------------------------
+ * Function: timeout
+ * - poll() timeout in ms until the nearest armed timer, rounded up so
+ *   the timer is due when poll() returns; -1 without timers.
+ *-------------------------------------------------------------------*/
+int EventLoop::timeout(uint64_t now_ns) const
+{
+	bool any = false;
+	uint64_t nearest = 0;
+	for(const Timer& timer: timers_)
+	{
+		if(timer.armed_ && (!any || timer.deadline_ns_ < nearest))
+		{
+			nearest = timer.deadline_ns_;
+			any = true;
+		}
+	}
+
+	if(!any)
+		return -1;
+	if(nearest <= now_ns)
+		return 0;
+	return static_cast<int>((nearest - now_ns + 999999) / 1000000);
+}
+
+/*-------------------------------------------------------------------
+ * File descriptors
+ *-------------------------------------------------------------------*/
+void EventLoop::addFd(int fd, short events, FdCallback callback)
+{
+	fds_.push_back(Fd{ fd, events, callback });
+}
+
+void EventLoop::removeFd(int fd)
+{
+	for(auto it = fds_.begin(); it != fds_.end(); ++it)
+	{
+		if(it->fd_ == fd)
+		{
+			fds_.erase(it);
+			return;
+		}
+	}
+}
+
+/*-------------------------------------------------------------------
+ * Function: wait
+ *-------------------------------------------------------------------*/
+void EventLoop::wait(int x_fd)
+{
+	pollfds_.resize(fds_.size() + 1);
+	pollfds_[0] = { x_fd, POLLIN, 0 };
+	for(::std::size_t i = 0; i < fds_.size(); ++i)
+		pollfds_[i + 1] = { fds_[i].fd_, fds_[i].events_, 0 };
+
+	const int ready = poll(pollfds_.data(), pollfds_.size(), timeout(EventStats::Now()));
+
+	// signals interrupt poll(); the caller checks its flags and comes back
+	if(ready < 0 && errno == EINTR)
+		return;
+
+	if(ready > 0)
+	{
+		// a callback may remove fds, so dispatch from the poll() copy
+		for(::std::size_t i = 1; i < pollfds_.size(); ++i)
+		{
+			if(pollfds_[i].revents == 0)
+				continue;
+			for(const Fd& fd: fds_)
+			{
+				if(fd.fd_ == pollfds_[i].fd)
+				{
+					FdCallback callback = fd.callback_;
+					callback(pollfds_[i].revents);
+					break;
+				}
+			}
+		}
+	}
+
+	runTimers(EventStats::Now());
+}
@@ -0,0 +1,75 @@
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <poll.h>
+
+/*-----------------------------------------------
+ * Class: EventLoop
+ * - the single place WindowManager::run() sleeps: one poll() over the
+ *   X connection, any extra file descriptors and the nearest timer.
+ * - timers are one-shot; their owner re-arms them (e.g. the drag timer
+ *   is armed at the next paced deadline while motion is pending).
+ * - callbacks run on the event thread, between batches of X events, so
+ *   they may use the display freely.
+ *-----------------------------------------------*/
+class EventLoop
+{
+public:
+	typedef unsigned int TimerId;
+	typedef ::std::function<void (uint64_t now_ns)> TimerCallback;
+	typedef ::std::function<void (short revents)> FdCallback;
+
+	/** Function: addTimer
+	 * - registers a disarmed timer.
+	 **/
+	TimerId addTimer(TimerCallback callback);
+	void armTimer(TimerId id, uint64_t deadline_ns);
+	void disarmTimer(TimerId id);
+	bool armed(TimerId id) const;
+
+	/** Function: addFd / removeFd
+	 * - callback runs with the revents of each poll() that reported fd.
+	 **/
+	void addFd(int fd, short events, FdCallback callback);
+	void removeFd(int fd);
+
+	/** Function: wait
+	 * - sleeps until x_fd is readable, an extra fd is ready or a timer
+	 *   is due, then runs the due timers and ready fd callbacks.
+	 * - the caller flushes its output before, and drains its event
+	 *   queue after.
+	 **/
+	void wait(int x_fd);
+
+	/** Function: runTimers
+	 * - runs (and disarms) every timer due at now_ns.
+	 **/
+	void runTimers(uint64_t now_ns);
+
+private:
+	struct Timer
+	{
+		bool armed_;
+		uint64_t deadline_ns_;
+		TimerCallback callback_;
+	};
+
+	struct Fd
+	{
+		int fd_;
+		short events_;
+		FdCallback callback_;
+	};
+
+	int timeout(uint64_t now_ns) const;
+
+	::std::vector<Timer> timers_;
+	::std::vector<Fd> fds_;
+	::std::vector<struct pollfd> pollfds_;
+};
+
+#endif
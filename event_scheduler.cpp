@@ -0,0 +1,124 @@
+#include "event_scheduler.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+EventScheduler::EventScheduler()
+	: input_run_(0),
+	  client_dispatched_(0),
+	  batches_(0),
+	  deferred_(0),
+	  motion_merged_(0)
+{
+	memset(input_types_, 0, sizeof(input_types_));
+	memset(stats_, 0, sizeof(stats_));
+
+	const int input_types[] = { KeyPress, KeyRelease, ButtonPress, ButtonRelease,
+		MotionNotify, EnterNotify, LeaveNotify, FocusIn, FocusOut, KeymapNotify };
+	for(int type: input_types)
+		addInputType(type);
+}
+
+void EventScheduler::addInputType(int type)
+{
+	if(type >= 0 && type < NUM_TYPES)
+		input_types_[type] = true;
+}
+
+EventScheduler::Lane EventScheduler::classify(const XEvent& e) const
+{
+	// the top bit only marks SendEvent
+	return input_types_[e.type & 0x7f] ? Input : Client;
+}
+
+void EventScheduler::push(const XEvent& e)
+{
+	const Lane lane = classify(e);
+	::std::deque<XEvent>& queue = lanes_[lane];
+
+	if(e.type == MotionNotify && !queue.empty() && 
+		queue.back().type == MotionNotify && queue.back().xmotion.window == e.xmotion.window)
+	{
+		queue.back() = e;
+		++motion_merged_;
+		return;
+	}
+
+	queue.push_back(e);
+	++stats_[lane].pushed_;
+	if(queue.size() > stats_[lane].depth_max_)
+		stats_[lane].depth_max_ = queue.size();
+}
+
+bool EventScheduler::pending() const
+{
+	return !lanes_[Input].empty() || !lanes_[Client].empty();
+}
+
+::std::size_t EventScheduler::size() const
+{
+	return lanes_[Input].size() + lanes_[Client].size();
+}
+
+::std::size_t EventScheduler::depth(Lane lane) const
+{
+	return lanes_[lane].size();
+}
+
+void EventScheduler::startBatch()
+{
+	input_run_ = 0;
+	client_dispatched_ = 0;
+	++batches_;
+	for(int lane = 0; lane < NUM_LANES; ++lane)
+		stats_[lane].depth_total_ += lanes_[lane].size();
+}
+
+bool EventScheduler::next(XEvent& e)
+{
+	::std::deque<XEvent>& input = lanes_[Input];
+	::std::deque<XEvent>& client = lanes_[Client];
+
+	const bool client_ready = !client.empty() && client_dispatched_ < client_budget_;
+	if(!input.empty() && (input_run_ < input_budget_ || !client_ready))
+	{
+		e = input.front();
+		input.pop_front();
+		++input_run_;
+		return true;
+	}
+
+	if(client_ready)
+	{
+		e = client.front();
+		client.pop_front();
+		input_run_ = 0;
+		++client_dispatched_;
+		return true;
+	}
+
+	deferred_ += client.size();
+	return false;
+}
+
+::std::string EventScheduler::toString() const
+{
+	static const char* names[NUM_LANES] = { "input", "client" };
+
+	::std::ostringstream out;
+	out << ::std::fixed << ::std::setprecision(1);
+	out << "EventScheduler {budgets: " << input_budget_ << " input / " << client_budget_ << " client"
+		<< ", deferred: " << deferred_
+		<< ", motion_merged: " << motion_merged_;
+	for(int lane = 0; lane < NUM_LANES; ++lane)
+	{
+		const LaneStats& s = stats_[lane];
+		out << ", " << names[lane] << " {events: " << s.pushed_
+			<< ", depth: " << lanes_[lane].size()
+			<< ", depth_avg: " << (batches_ ? static_cast<double>(s.depth_total_) / batches_ : 0.0)
+			<< ", depth_max: " << s.depth_max_ << "}";
+	}
+	out << " }";
+	return out.str();
+}
@@ -0,0 +1,90 @@
+#ifndef EVENT_SCHEDULER_HPP
+#define EVENT_SCHEDULER_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+/*-----------------------------------------------
+ * Class: EventScheduler
+ * - orders the events of a batch so the user's input is not stuck
+ *   behind a client's event storm.
+ * - events are split into two FIFO lanes: Input (pointer, keyboard,
+ *   crossing, and any type added with addInputType) and Client
+ *   (everything else: requests, notifies, exposes, property changes).
+ * - within a batch pending input always goes first, but after
+ *   input_budget_ input events in a row a waiting client event gets a
+ *   turn. At most client_budget_ client events are dispatched per batch,
+ *   the rest wait for the next batch, after the input read since.
+ * - consecutive MotionNotify of the same window are merged on push, only
+ *   the latest position matters.
+ *-----------------------------------------------*/
+class EventScheduler
+{
+public:
+	enum Lane
+	{
+		Input,
+		Client,
+		NUM_LANES
+	};
+
+	unsigned int input_budget_ = 64;
+	unsigned int client_budget_ = 256;
+
+	EventScheduler();
+
+	/** Function: addInputType
+	 * - routes events of type (e.g. an extension event) to the input lane.
+	 **/
+	void addInputType(int type);
+	Lane classify(const XEvent& e) const;
+
+	void push(const XEvent& e);
+	/** Function: pending
+	 * - true while either lane holds events, including client events
+	 *   deferred by an earlier batch.
+	 **/
+	bool pending() const;
+	::std::size_t size() const;
+	::std::size_t depth(Lane lane) const;
+
+	/** Function: startBatch
+	 * - resets the budgets; call after pushing the batch's events.
+	 **/
+	void startBatch();
+	/** Function: next
+	 * - the next event to dispatch in this batch, false once the batch
+	 *   is done (no input left, and no client event or no budget left).
+	 **/
+	bool next(XEvent& e);
+
+	::std::string toString() const;
+
+private:
+	struct LaneStats
+	{
+		uint64_t pushed_;
+		uint64_t depth_total_;		// summed at every startBatch
+		::std::size_t depth_max_;
+	};
+
+	static const int NUM_TYPES = 128;
+
+	bool input_types_[NUM_TYPES];
+	::std::deque<XEvent> lanes_[NUM_LANES];
+
+	unsigned int input_run_;			// input dispatched since the last client event
+	unsigned int client_dispatched_;	// client events dispatched this batch
+
+	LaneStats stats_[NUM_LANES];
+	uint64_t batches_;
+	uint64_t deferred_;					// client events carried into a later batch
+	uint64_t motion_merged_;
+};
+
+#endif
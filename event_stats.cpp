@@ -0,0 +1,139 @@
+#include "event_stats.hpp"
+#include "util.hpp"
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+/*-------------------------------------------------------------------
+ * LatencyHistogram
+ *-------------------------------------------------------------------*/
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::reset()
+{
+	memset(buckets_, 0, sizeof(buckets_));
+	count_ = 0;
+	total_ns_ = 0;
+	max_ns_ = 0;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+	uint64_t us = ns / 1000;
+	unsigned int bucket = 0;
+	while(us && bucket < NUM_BUCKETS - 1)
+	{
+		us >>= 1;
+		++bucket;
+	}
+
+	++buckets_[bucket];
+	++count_;
+	total_ns_ += ns;
+	if(ns > max_ns_)
+		max_ns_ = ns;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+	if(count_ == 0)
+		return 0;
+
+	const uint64_t rank = static_cast<uint64_t>(p * (count_ - 1)) + 1;
+	uint64_t seen = 0;
+	for(unsigned int i = 0; i < NUM_BUCKETS; ++i)
+	{
+		seen += buckets_[i];
+		if(seen >= rank)
+		{
+			const uint64_t upper_ns = (static_cast<uint64_t>(1) << i) * 1000;
+			return upper_ns < max_ns_ ? upper_ns : max_ns_;
+		}
+	}
+	return max_ns_;
+}
+
+/*-------------------------------------------------------------------
+ * EventStats
+ *-------------------------------------------------------------------*/
+EventStats::EventStats()
+	: start_ns_(Now()),
+	  last_dump_ns_(start_ns_),
+	  events_total_(0),
+	  events_since_dump_(0),
+	  queue_depth_total_(0),
+	  queue_depth_max_(0),
+	  batches_(0),
+	  batch_max_(0)
+{
+
+}
+
+uint64_t EventStats::Now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+void EventStats::record(int event_type, uint64_t ns)
+{
+	if(event_type < 0 || event_type >= LASTEvent)
+		return;
+	histograms_[event_type].record(ns);
+	++events_total_;
+	++events_since_dump_;
+}
+
+void EventStats::recordQueueDepth(int depth)
+{
+	queue_depth_total_ += depth;
+	if(depth > queue_depth_max_)
+		queue_depth_max_ = depth;
+}
+
+void EventStats::recordBatch(int size)
+{
+	++batches_;
+	if(size > batch_max_)
+		batch_max_ = size;
+}
+
+::std::string EventStats::toString()
+{
+	const uint64_t now = Now();
+	const double uptime_s = (now - start_ns_) / 1e9;
+	const double window_s = (now - last_dump_ns_) / 1e9;
+
+	::std::ostringstream out;
+	out << ::std::fixed << ::std::setprecision(1);
+	out << "EventStats {uptime: " << uptime_s << "s"
+		<< ", events: " << events_total_
+		<< ", events/sec: " << (window_s > 0 ? events_since_dump_ / window_s : 0.0)
+		<< ", queue_depth_avg: "
+		<< (events_total_ ? static_cast<double>(queue_depth_total_) / events_total_ : 0.0)
+		<< ", queue_depth_max: " << queue_depth_max_
+		<< ", batches: " << batches_
+		<< ", batch_avg: " << (batches_ ? static_cast<double>(events_total_) / batches_ : 0.0)
+		<< ", batch_max: " << batch_max_ << " }\n";
+
+	for(int type = 0; type < LASTEvent; ++type)
+	{
+		const LatencyHistogram& h = histograms_[type];
+		if(h.count_ == 0)
+			continue;
+		out << "\t" << ::std::left << ::std::setw(18) << XEventTypeToString(type) << ::std::right
+			<< " n=" << h.count_
+			<< " p50=" << h.percentile(0.50) / 1000.0 << "us"
+			<< " p99=" << h.percentile(0.99) / 1000.0 << "us"
+			<< " max=" << h.max_ns_ / 1000.0 << "us\n";
+	}
+
+	last_dump_ns_ = now;
+	events_since_dump_ = 0;
+	return out.str();
+}
@@ -0,0 +1,80 @@
+#ifndef EVENT_STATS_HPP
+#define EVENT_STATS_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstdint>
+#include <string>
+
+/*-----------------------------------------------
+ * Class: LatencyHistogram
+ * - fixed bucket histogram of handler latencies.
+ * - bucket i holds samples in [2^(i-1), 2^i) microseconds, bucket 0
+ *   holds everything under 1us. No allocation on record().
+ *-----------------------------------------------*/
+class LatencyHistogram
+{
+public:
+	static const unsigned int NUM_BUCKETS = 32;
+
+	uint64_t buckets_[NUM_BUCKETS];
+	uint64_t count_;
+	uint64_t total_ns_;
+	uint64_t max_ns_;
+
+	LatencyHistogram();
+
+	void record(uint64_t ns);
+	/** Function: percentile
+	 * - returns the upper bound (in ns) of the bucket holding the
+	 *   requested percentile, clamped to the largest sample seen.
+	 **/
+	uint64_t percentile(double p) const;
+	void reset();
+};
+
+/*-----------------------------------------------
+ * Class: EventStats
+ * - per event type latency histograms for WindowManager::run()
+ * - events/sec, X queue depth and dispatch batch counters
+ *-----------------------------------------------*/
+class EventStats
+{
+public:
+	LatencyHistogram histograms_[LASTEvent];
+
+	uint64_t start_ns_;
+	uint64_t last_dump_ns_;
+	uint64_t events_total_;
+	uint64_t events_since_dump_;
+
+	uint64_t queue_depth_total_;
+	int queue_depth_max_;
+
+	uint64_t batches_;
+	int batch_max_;
+
+	EventStats();
+
+	/** Function: Now
+	 * - monotonic clock in nanoseconds
+	 **/
+	static uint64_t Now();
+
+	void record(int event_type, uint64_t ns);
+	void recordQueueDepth(int depth);
+	/** Function: recordBatch
+	 * - events dispatched between two flushes of the main loop.
+	 **/
+	void recordBatch(int size);
+
+	/** Function: toString
+	 * - p50/p99/max per event type seen since start, plus rates.
+	 * - resets the events/sec window.
+	 **/
+	::std::string toString();
+};
+
+#endif
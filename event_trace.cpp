@@ -0,0 +1,226 @@
+#include "event_trace.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glog/logging.h>
+
+static const char TRACE_MAGIC[8] = { 'S', 'W', 'I', 'M', 'T', 'R', 'C', '1' };
+static const ::std::size_t INITIAL_CAPACITY = 1 << 20;
+
+/*-------------------------------------------------------------------
+ * EventTraceWriter
+ *-------------------------------------------------------------------*/
+EventTraceWriter::EventTraceWriter()
+	: fd_(-1), map_(nullptr), capacity_(0)
+{
+}
+
+EventTraceWriter::~EventTraceWriter()
+{
+	close();
+}
+
+bool EventTraceWriter::open(const ::std::string& path, Window root)
+{
+	close();
+
+	fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd_ < 0)
+	{
+		LOG(ERROR) << "Cannot create event trace " << path << ": " << strerror(errno);
+		return false;
+	}
+
+	if(ftruncate(fd_, INITIAL_CAPACITY) != 0)
+	{
+		LOG(ERROR) << "Cannot size event trace " << path << ": " << strerror(errno);
+		close();
+		return false;
+	}
+	void* map = mmap(nullptr, INITIAL_CAPACITY, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+	if(map == MAP_FAILED)
+	{
+		LOG(ERROR) << "Cannot map event trace " << path << ": " << strerror(errno);
+		close();
+		return false;
+	}
+	map_ = static_cast<unsigned char*>(map);
+	capacity_ = INITIAL_CAPACITY;
+
+	EventTraceHeader* header = reinterpret_cast<EventTraceHeader*>(map_);
+	memcpy(header->magic_, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	header->record_size_ = sizeof(EventTraceRecord);
+	header->reserved_ = 0;
+	header->root_ = root;
+	header->record_count_ = 0;
+
+	LOG(INFO) << "Recording event trace to " << path;
+	return true;
+}
+
+bool EventTraceWriter::isOpen() const
+{
+	return map_ != nullptr;
+}
+
+/*-------------------------------------------------------------------
+ * Function: next
+ * - the slot for the next record, nullptr if the file cannot grow.
+ *-------------------------------------------------------------------*/
+EventTraceRecord* EventTraceWriter::next(uint64_t time_ns, EventTraceKind kind)
+{
+	const EventTraceHeader* header = reinterpret_cast<EventTraceHeader*>(map_);
+	const ::std::size_t offset = sizeof(EventTraceHeader) +
+		header->record_count_ * sizeof(EventTraceRecord);
+	if(offset + sizeof(EventTraceRecord) > capacity_ && !grow())
+		return nullptr;
+
+	EventTraceRecord* record = reinterpret_cast<EventTraceRecord*>(map_ + offset);
+	record->time_ns_ = time_ns;
+	record->kind_ = kind;
+	record->reserved_ = 0;
+	return record;
+}
+
+bool EventTraceWriter::grow()
+{
+	const ::std::size_t capacity = capacity_ * 2;
+	if(ftruncate(fd_, capacity) != 0)
+	{
+		LOG(ERROR) << "Event trace full, stopped recording: " << strerror(errno);
+		close();
+		return false;
+	}
+
+	munmap(map_, capacity_);
+	void* map = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+	if(map == MAP_FAILED)
+	{
+		map_ = nullptr;
+		LOG(ERROR) << "Cannot remap event trace, stopped recording: " << strerror(errno);
+		close();
+		return false;
+	}
+	map_ = static_cast<unsigned char*>(map);
+	capacity_ = capacity;
+	return true;
+}
+
+void EventTraceWriter::append(uint64_t time_ns, const XEvent& e)
+{
+	EventTraceRecord* record = next(time_ns, EventTraceKind::Event);
+	if(record == nullptr)
+		return;
+	record->event_ = e;
+	++reinterpret_cast<EventTraceHeader*>(map_)->record_count_;
+}
+
+void EventTraceWriter::appendFramed(uint64_t time_ns, const Window (&windows)[6])
+{
+	EventTraceRecord* record = next(time_ns, EventTraceKind::Framed);
+	if(record == nullptr)
+		return;
+	memset(&record->event_, 0, sizeof(record->event_));
+	memcpy(record->framed_, windows, sizeof(windows));
+	++reinterpret_cast<EventTraceHeader*>(map_)->record_count_;
+}
+
+void EventTraceWriter::appendBatchEnd(uint64_t time_ns)
+{
+	EventTraceRecord* record = next(time_ns, EventTraceKind::BatchEnd);
+	if(record == nullptr)
+		return;
+	memset(&record->event_, 0, sizeof(record->event_));
+	++reinterpret_cast<EventTraceHeader*>(map_)->record_count_;
+}
+
+void EventTraceWriter::close()
+{
+	if(map_)
+	{
+		const EventTraceHeader* header = reinterpret_cast<EventTraceHeader*>(map_);
+		const ::std::size_t used = sizeof(EventTraceHeader) +
+			header->record_count_ * sizeof(EventTraceRecord);
+		munmap(map_, capacity_);
+		if(ftruncate(fd_, used) != 0)
+			LOG(WARNING) << "Cannot trim event trace: " << strerror(errno);
+	}
+	if(fd_ >= 0)
+		::close(fd_);
+
+	fd_ = -1;
+	map_ = nullptr;
+	capacity_ = 0;
+}
+
+/*-------------------------------------------------------------------
+ * EventTraceReader
+ *-------------------------------------------------------------------*/
+EventTraceReader::EventTraceReader()
+	: fd_(-1), map_(nullptr), length_(0), header_(nullptr)
+{
+}
+
+EventTraceReader::~EventTraceReader()
+{
+	if(map_)
+		munmap(const_cast<unsigned char*>(map_), length_);
+	if(fd_ >= 0)
+		::close(fd_);
+}
+
+bool EventTraceReader::open(const ::std::string& path)
+{
+	fd_ = ::open(path.c_str(), O_RDONLY);
+	struct stat st;
+	if(fd_ < 0 || fstat(fd_, &st) != 0)
+	{
+		LOG(ERROR) << "Cannot open event trace " << path << ": " << strerror(errno);
+		return false;
+	}
+
+	length_ = st.st_size;
+	if(length_ < sizeof(EventTraceHeader))
+	{
+		LOG(ERROR) << path << " is not an event trace";
+		return false;
+	}
+
+	void* map = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd_, 0);
+	if(map == MAP_FAILED)
+	{
+		LOG(ERROR) << "Cannot map event trace " << path << ": " << strerror(errno);
+		return false;
+	}
+	map_ = static_cast<const unsigned char*>(map);
+	header_ = reinterpret_cast<const EventTraceHeader*>(map_);
+
+	if(memcmp(header_->magic_, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+		header_->record_size_ != sizeof(EventTraceRecord) ||
+		sizeof(EventTraceHeader) + header_->record_count_ * sizeof(EventTraceRecord) > length_)
+	{
+		LOG(ERROR) << path << " is not an event trace of this build";
+		header_ = nullptr;
+		return false;
+	}
+	return true;
+}
+
+Window EventTraceReader::root() const
+{
+	return header_->root_;
+}
+
+uint64_t EventTraceReader::size() const
+{
+	return header_ ? header_->record_count_ : 0;
+}
+
+const EventTraceRecord& EventTraceReader::operator [] (uint64_t i) const
+{
+	return reinterpret_cast<const EventTraceRecord*>(map_ + sizeof(EventTraceHeader))[i];
+}
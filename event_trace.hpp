@@ -0,0 +1,115 @@
+#ifndef EVENT_TRACE_HPP
+#define EVENT_TRACE_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*-----------------------------------------------
+ * Binary event trace
+ * - a header followed by fixed size records, one per XEvent taken off
+ *   the queue by WindowManager::run() (before the scheduler merges
+ *   any), plus one Framed record per client the WM decorates (so a
+ *   replay can map the recorded decoration ids onto the ones it creates
+ *   itself), and one BatchEnd record per batch, where the WM applied
+ *   its deferred work and flushed.
+ * - the file is written through a shared mapping, so a trace survives
+ *   the WM crashing; record_count_ is only bumped once a record is
+ *   complete.
+ *-----------------------------------------------*/
+struct EventTraceHeader
+{
+	char magic_[8];			// "SWIMTRC1"
+	uint32_t record_size_;	// sizeof(EventTraceRecord) of the writer
+	uint32_t reserved_;
+	uint64_t root_;			// root window of the recorded session
+	uint64_t record_count_;
+};
+
+enum class EventTraceKind : uint32_t
+{
+	Event,		// event_ as received
+	Framed,		// framed_: application, frame, border, move, resize, close
+	BatchEnd	// WindowManager::endBatch() ran
+};
+
+struct EventTraceRecord
+{
+	uint64_t time_ns_;		// EventStats::Now() when received
+	EventTraceKind kind_;
+	uint32_t reserved_;
+	union
+	{
+		XEvent event_;
+		Window framed_[6];
+	};
+};
+
+/*-----------------------------------------------
+ * Class: EventTraceWriter
+ * - appends records to a memory-mapped trace file, growing the file
+ *   (and the mapping) by doubling, so append() is a copy into memory.
+ *-----------------------------------------------*/
+class EventTraceWriter
+{
+public:
+	EventTraceWriter();
+	~EventTraceWriter();
+
+	/** Function: open
+	 * - creates (truncates) path. false, and logged, if it cannot be
+	 *   created or mapped.
+	 **/
+	bool open(const ::std::string& path, Window root);
+	bool isOpen() const;
+
+	void append(uint64_t time_ns, const XEvent& e);
+	void appendFramed(uint64_t time_ns, const Window (&windows)[6]);
+	void appendBatchEnd(uint64_t time_ns);
+
+	/** Function: close
+	 * - trims the file to the records written and unmaps it.
+	 **/
+	void close();
+
+private:
+	EventTraceRecord* next(uint64_t time_ns, EventTraceKind kind);
+	bool grow();
+
+	int fd_;
+	unsigned char* map_;
+	::std::size_t capacity_;	// bytes mapped (== file size)
+};
+
+/*-----------------------------------------------
+ * Class: EventTraceReader
+ * - maps a trace read-only, records are used in place.
+ *-----------------------------------------------*/
+class EventTraceReader
+{
+public:
+	EventTraceReader();
+	~EventTraceReader();
+
+	/** Function: open
+	 * - false, and logged, if path is not a trace of this build's
+	 *   record layout.
+	 **/
+	bool open(const ::std::string& path);
+
+	Window root() const;
+	uint64_t size() const;
+	const EventTraceRecord& operator [] (uint64_t i) const;
+
+private:
+	int fd_;
+	const unsigned char* map_;
+	::std::size_t length_;
+	const EventTraceHeader* header_;
+};
+
+#endif
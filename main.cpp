@@ -11,7 +11,10 @@ int main(int argc, char** argv)
 
 	// Creating a smart pointer to the window manager of type WindowManager
 	// This method invokes the constructor of the WindowManager object
-	::std::unique_ptr<WindowManager> window_manager = WindowManager::Create();
+	const Config config = Config::FromEnvironment();
+	LOG(INFO) << "main.cpp: " << config.toString();
+
+	::std::unique_ptr<WindowManager> window_manager = WindowManager::Create(::std::string(), config);
 
 	// If window manager is NULL
 	if (!window_manager)
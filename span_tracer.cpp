@@ -0,0 +1,65 @@
+#include "span_tracer.hpp"
+
+#include <cstdio>
+#include <unistd.h>
+
+bool SpanTracer::enabled_ = false;
+::std::vector<SpanTracer::Span> SpanTracer::spans_;
+uint64_t SpanTracer::dropped_ = 0;
+
+void SpanTracer::start()
+{
+	spans_.clear();
+	spans_.reserve(1 << 16);
+	dropped_ = 0;
+	enabled_ = true;
+}
+
+void SpanTracer::record(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+	if(spans_.size() >= MAX_SPANS)
+	{
+		++dropped_;
+		return;
+	}
+	spans_.push_back(Span{ name, start_ns, end_ns - start_ns });
+}
+
+/*-------------------------------------------------------------------
+ * Function: stop
+ * - one complete ("X") event per span; the viewer nests them by time.
+ *   Timestamps are microseconds on CLOCK_MONOTONIC.
+ *-------------------------------------------------------------------*/
+bool SpanTracer::stop(const ::std::string& path)
+{
+	enabled_ = false;
+
+	FILE* file = fopen(path.c_str(), "w");
+	if(file == nullptr)
+		return false;
+
+	const int pid = getpid();
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for(::std::size_t i = 0; i < spans_.size(); ++i)
+	{
+		const Span& span = spans_[i];
+		fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"swim\",\"ph\":\"X\","
+			"\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}\n",
+			i ? "," : "", span.name_, span.start_ns_ / 1e3, span.duration_ns_ / 1e3, pid, pid);
+	}
+	fprintf(file, "]}\n");
+
+	const bool written = !ferror(file);
+	fclose(file);
+	return written;
+}
+
+::std::size_t SpanTracer::size()
+{
+	return spans_.size();
+}
+
+uint64_t SpanTracer::dropped()
+{
+	return dropped_;
+}
@@ -0,0 +1,86 @@
+#ifndef SPAN_TRACER_HPP
+#define SPAN_TRACER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "event_stats.hpp"
+
+/*-----------------------------------------------
+ * Class: SpanTracer
+ * - in-memory recording of timed spans (handler calls and the X work
+ *   they do), written out as Chrome trace-event JSON, which Perfetto
+ *   and chrome://tracing open directly.
+ * - process wide, like the glog macros: spans are opened with
+ *   TRACE_SPAN in any function without threading a tracer through.
+ * - while disabled a span costs one branch on enabled_.
+ *-----------------------------------------------*/
+class SpanTracer
+{
+public:
+	struct Span
+	{
+		const char* name_;		// must outlive the recording (string literals)
+		uint64_t start_ns_;
+		uint64_t duration_ns_;
+	};
+
+	// spans past this are dropped (and counted), about 24 MiB of spans
+	static const ::std::size_t MAX_SPANS = 1 << 20;
+
+	static bool enabled_;
+
+	/** Function: start
+	 * - drops any previous recording and enables recording.
+	 **/
+	static void start();
+	/** Function: stop
+	 * - disables recording and writes what was recorded to path.
+	 *   false if path cannot be written.
+	 **/
+	static bool stop(const ::std::string& path);
+
+	static void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+	static ::std::size_t size();
+	static uint64_t dropped();
+
+private:
+	static ::std::vector<Span> spans_;
+	static uint64_t dropped_;
+};
+
+/*-----------------------------------------------
+ * Class: TraceSpan
+ * - records the span from its construction to the end of its scope.
+ *-----------------------------------------------*/
+class TraceSpan
+{
+public:
+	explicit TraceSpan(const char* name)
+		: name_(SpanTracer::enabled_ ? name : nullptr),
+		  start_ns_(name_ ? EventStats::Now() : 0)
+	{
+	}
+	~TraceSpan()
+	{
+		if(name_)
+			SpanTracer::record(name_, start_ns_, EventStats::Now());
+	}
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator = (const TraceSpan&) = delete;
+
+private:
+	const char* const name_;
+	const uint64_t start_ns_;
+};
+
+#define TRACE_SPAN_CONCAT_(a, b) a##b
+#define TRACE_SPAN_NAME_(line) TRACE_SPAN_CONCAT_(trace_span_, line)
+// TRACE_SPAN("name"); times the rest of the enclosing scope
+#define TRACE_SPAN(name) TraceSpan TRACE_SPAN_NAME_(__LINE__)(name)
+
+#endif
@@ -0,0 +1,306 @@
+/*-------------------------------------------------------------------
+ * swim_bench
+ * - Interactive latency benchmark, run against a headless X server
+ *   with basic_wm already managing it (see bench.sh).
+ * - map_to_framed : XMapWindow on a new client until its border
+ *                   window is viewable.
+ * - drag_move     : synthetic (XTest) pointer step over move_button_
+ *                   until the border window has moved.
+ * - drag_resize   : same as drag_move, over resize_button_.
+ * - configure_burst: num_configures XResizeWindow requests on one
+ *                   client, as fast as they can be written, until the
+ *                   last size is granted. Also reports how many
+ *                   configures the WM made on the client and its border
+ *                   for them (one per request without coalescing).
+ * - every sample is written to stdout as CSV (metric,sample,usec),
+ *   a p50/p99/max summary of each metric is written to stderr.
+ *-------------------------------------------------------------------*/
+extern "C" {
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XTest.h>
+}
+
+#include <poll.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "event_stats.hpp"
+
+// Decoration layout, mirrors XLib_Window::createWindow
+static const int BUTTON_SIZE = 8;
+static const int BUTTON_MARGIN = 5;
+static const int MOVE_BUTTON_INDEX = 1;
+static const int RESIZE_BUTTON_INDEX = 2;
+
+static const uint64_t TIMEOUT_NS = 2000000000ull;
+
+/*-------------------------------------------------------------------
+ * Function: waitForEvent
+ * - waits for an event of type on window, dropping everything else.
+ * - returns false once timeout_ns has passed.
+ *-------------------------------------------------------------------*/
+template <typename Predicate>
+static bool waitForEvent(Display* display, Window w, int type, XEvent* e, Predicate predicate)
+{
+	const uint64_t deadline = EventStats::Now() + TIMEOUT_NS;
+	for(;;)
+	{
+		while(XPending(display))
+		{
+			XNextEvent(display, e);
+			if(e->type == type && e->xany.window == w && predicate(*e))
+				return true;
+		}
+
+		const uint64_t now = EventStats::Now();
+		if(now >= deadline)
+			return false;
+
+		struct pollfd fd = { ConnectionNumber(display), POLLIN, 0 };
+		poll(&fd, 1, static_cast<int>((deadline - now) / 1000000) + 1);
+	}
+}
+
+static Window parentOf(Display* display, Window w)
+{
+	Window returned_root, returned_parent;
+	Window* children;
+	unsigned int num_children;
+	if(!XQueryTree(display, w, &returned_root, &returned_parent, &children, &num_children))
+		return None;
+	if(children)
+		XFree(children);
+	return returned_parent;
+}
+
+static void report(const char* metric, int sample, uint64_t ns, LatencyHistogram& histogram)
+{
+	printf("%s,%d,%.1f\n", metric, sample, ns / 1000.0);
+	histogram.record(ns);
+}
+
+static void summarise(const char* metric, const LatencyHistogram& h, int timeouts)
+{
+	fprintf(stderr, "%-14s n=%llu p50=%.1fus p99=%.1fus max=%.1fus timeouts=%d\n",
+		metric,
+		static_cast<unsigned long long>(h.count_),
+		h.percentile(0.50) / 1000.0,
+		h.percentile(0.99) / 1000.0,
+		h.max_ns_ / 1000.0,
+		timeouts);
+}
+
+/*-------------------------------------------------------------------
+ * Function: benchDrag
+ * - presses Button1 over a decoration button of border and steps the
+ *   pointer num_steps times, timing each step until the border
+ *   window's ConfigureNotify reflects it.
+ *-------------------------------------------------------------------*/
+static void benchDrag(Display* display, Window border, int button_index,
+	int num_steps, const char* metric)
+{
+	Window returned_root;
+	int x, y;
+	unsigned int width, height, border_width, depth;
+	XGetGeometry(display, border, &returned_root, &x, &y, &width, &height, &border_width, &depth);
+
+	const int start_x = x + width - (BUTTON_SIZE + BUTTON_MARGIN) * button_index + BUTTON_SIZE / 2;
+	const int start_y = y + BUTTON_MARGIN + BUTTON_SIZE / 2;
+	const bool moving = (button_index == MOVE_BUTTON_INDEX);
+
+	XSelectInput(display, border, StructureNotifyMask);
+	XTestFakeMotionEvent(display, -1, start_x, start_y, CurrentTime);
+	XTestFakeButtonEvent(display, Button1, True, CurrentTime);
+	XSync(display, False);
+
+	LatencyHistogram histogram;
+	int timeouts = 0;
+	XEvent e;
+	for(int step = 1; step <= num_steps; ++step)
+	{
+		const int expected_x = x + step;
+		const int expected_width = width + step;
+
+		const uint64_t start_ns = EventStats::Now();
+		XTestFakeMotionEvent(display, -1, start_x + step, start_y, CurrentTime);
+		XFlush(display);
+
+		const bool applied = waitForEvent(display, border, ConfigureNotify, &e,
+			[&] (const XEvent& c) {
+				return moving ? c.xconfigure.x == expected_x : c.xconfigure.width == expected_width;
+			});
+		if(applied)
+			report(metric, step, EventStats::Now() - start_ns, histogram);
+		else
+			++timeouts;
+	}
+
+	XTestFakeButtonEvent(display, Button1, False, CurrentTime);
+	XSelectInput(display, border, NoEventMask);
+	XSync(display, False);
+
+	summarise(metric, histogram, timeouts);
+}
+
+/*-------------------------------------------------------------------
+ * Function: benchConfigureBurst
+ * - sizes cycle within 300..399 x 200..249, the last request asks for
+ *   450x300 so only it can satisfy the wait.
+ *-------------------------------------------------------------------*/
+static void benchConfigureBurst(Display* display, Window w, Window border, int num_requests)
+{
+	const int final_width = 450;
+	const int final_height = 300;
+
+	XSelectInput(display, w, StructureNotifyMask);
+	XSelectInput(display, border, StructureNotifyMask);
+	XSync(display, False);
+	while(XPending(display))
+	{
+		XEvent e;
+		XNextEvent(display, &e);
+	}
+
+	const uint64_t start_ns = EventStats::Now();
+	for(int i = 0; i < num_requests - 1; ++i)
+		XResizeWindow(display, w, 300 + i % 100, 200 + i % 50);
+	XResizeWindow(display, w, final_width, final_height);
+	XFlush(display);
+
+	int client_configures = 0;
+	int border_configures = 0;
+	bool granted = false;
+	const uint64_t deadline = start_ns + TIMEOUT_NS * 5;
+	while(!granted && EventStats::Now() < deadline)
+	{
+		if(!XPending(display))
+		{
+			struct pollfd fd = { ConnectionNumber(display), POLLIN, 0 };
+			poll(&fd, 1, 10);
+			continue;
+		}
+
+		XEvent e;
+		XNextEvent(display, &e);
+		if(e.type != ConfigureNotify)
+			continue;
+		if(e.xconfigure.window == border)
+			++border_configures;
+		else if(e.xconfigure.window == w)
+		{
+			++client_configures;
+			granted = e.xconfigure.width == final_width && e.xconfigure.height == final_height;
+		}
+	}
+	const uint64_t elapsed_ns = EventStats::Now() - start_ns;
+
+	// the border's last configure may trail the client's
+	XSync(display, False);
+	while(XPending(display))
+	{
+		XEvent e;
+		XNextEvent(display, &e);
+		if(e.type == ConfigureNotify && e.xconfigure.window == border)
+			++border_configures;
+	}
+	XSelectInput(display, w, NoEventMask);
+	XSelectInput(display, border, NoEventMask);
+
+	printf("configure_burst,%d,%.1f\n", num_requests, elapsed_ns / 1000.0);
+	fprintf(stderr, "%-14s requests=%d total=%.1fms client_configures=%d border_configures=%d%s\n",
+		"configure_burst", num_requests, elapsed_ns / 1e6,
+		client_configures, border_configures, granted ? "" : " (timeout)");
+}
+
+int main(int argc, char** argv)
+{
+	const int num_clients = argc > 1 ? atoi(argv[1]) : 20;
+	const int num_steps = argc > 2 ? atoi(argv[2]) : 100;
+	const int num_configures = argc > 3 ? atoi(argv[3]) : 10000;
+
+	Display* display = XOpenDisplay(nullptr);
+	if(display == nullptr)
+	{
+		fprintf(stderr, "swim_bench: failed to open X display %s\n", XDisplayName(nullptr));
+		return EXIT_FAILURE;
+	}
+
+	int event_base, error_base, major, minor;
+	if(!XTestQueryExtension(display, &event_base, &error_base, &major, &minor))
+	{
+		fprintf(stderr, "swim_bench: XTest extension not available\n");
+		return EXIT_FAILURE;
+	}
+
+	const int screen = DefaultScreen(display);
+	const Window root = RootWindow(display, screen);
+
+	printf("metric,sample,usec\n");
+
+	/** (1) map_to_framed **/
+	LatencyHistogram map_histogram;
+	int map_timeouts = 0;
+	Window client = None;
+	Window border = None;
+	for(int i = 0; i < num_clients; ++i)
+	{
+		Window w = XCreateSimpleWindow(display, root,
+			20 + (i % 40) * 10, 40 + (i % 40) * 10, 300, 200, 0,
+			BlackPixel(display, screen), WhitePixel(display, screen));
+		XSelectInput(display, w, StructureNotifyMask);
+		XSync(display, False);
+
+		const uint64_t start_ns = EventStats::Now();
+		XMapWindow(display, w);
+		XFlush(display);
+
+		XEvent e;
+		if(!waitForEvent(display, w, MapNotify, &e, [] (const XEvent&) { return true; }))
+		{
+			++map_timeouts;
+			continue;
+		}
+
+		// application window -> frame_ -> border_window_
+		const Window frame = parentOf(display, w);
+		border = (frame == root) ? None : parentOf(display, frame);
+		if(border == None || border == root)
+		{
+			fprintf(stderr, "swim_bench: client %d was not framed, is basic_wm running?\n", i);
+			return EXIT_FAILURE;
+		}
+
+		XWindowAttributes attrs;
+		XGetWindowAttributes(display, border, &attrs);
+		if(attrs.map_state != IsViewable)
+		{
+			XSelectInput(display, border, StructureNotifyMask);
+			if(!waitForEvent(display, border, MapNotify, &e, [] (const XEvent&) { return true; }))
+			{
+				++map_timeouts;
+				continue;
+			}
+			XSelectInput(display, border, NoEventMask);
+		}
+
+		report("map_to_framed", i, EventStats::Now() - start_ns, map_histogram);
+		client = w;
+	}
+	summarise("map_to_framed", map_histogram, map_timeouts);
+
+	/** (2) drag_move / drag_resize on the last (top most) client **/
+	if(border != None && num_steps > 0)
+	{
+		benchDrag(display, border, MOVE_BUTTON_INDEX, num_steps, "drag_move");
+		benchDrag(display, border, RESIZE_BUTTON_INDEX, num_steps, "drag_resize");
+	}
+
+	/** (3) configure_burst on the same client **/
+	if(client != None && num_configures > 0)
+		benchConfigureBurst(display, client, border, num_configures);
+
+	XCloseDisplay(display);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+/*-------------------------------------------------------------------
+ * swim_replay
+ * - feeds an event trace recorded with SWIM_TRACE back through the
+ *   WM's scheduler and handlers as fast as possible, against a
+ *   headless X server (run it on an Xvfb display nothing else manages).
+ * - client windows of the recorded session are recreated on the replay
+ *   server the first time a CreateNotify, MapRequest or ConfigureRequest
+ *   names them; the Framed records map the recorded decoration windows
+ *   onto the ones the replaying WM creates. Every other window id is
+ *   passed through as recorded. Clients the recorded WM adopted at
+ *   startup are not recreated.
+ * - events are recorded as received; each BatchEnd record dispatches
+ *   what was queued since through the scheduler (which merges motion
+ *   and orders the lanes as it did live), then runs endBatch().
+ * - per event type handler latency (the SIGUSR1 stats format) and the
+ *   overall replay rate are written to stdout.
+ *
+ *   swim_replay TRACE          replay TRACE on $DISPLAY
+ *   swim_replay --dump TRACE   print TRACE, no X server needed
+ *-------------------------------------------------------------------*/
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <glog/logging.h>
+
+#include "event_stats.hpp"
+#include "event_trace.hpp"
+#include "util.hpp"
+#include "window_manager.hpp"
+
+static unsigned long x_errors = 0;
+
+static int countXError(Display* display, XErrorEvent* e)
+{
+	++x_errors;
+	return 0;
+}
+
+/*-------------------------------------------------------------------
+ * Class: WindowTranslator
+ * - recorded window id -> replay window id.
+ *-------------------------------------------------------------------*/
+class WindowTranslator
+{
+public:
+	WindowTranslator(Display* client_display, Window recorded_root)
+		: client_display_(client_display),
+		  recorded_root_(recorded_root),
+		  root_(DefaultRootWindow(client_display))
+	{
+	}
+
+	Window translate(Window w) const
+	{
+		if(w == recorded_root_)
+			return root_;
+		auto it = map_.find(w);
+		return it == map_.end() ? w : it->second;
+	}
+
+	/** Function: client
+	 * - the replay window for a recorded client window, created (on the
+	 *   client connection) with the given geometry if it is new.
+	 **/
+	Window client(Window w, int x, int y, int width, int height)
+	{
+		auto it = map_.find(w);
+		if(it != map_.end())
+			return it->second;
+
+		const int screen = DefaultScreen(client_display_);
+		const Window replay = XCreateSimpleWindow(client_display_, root_, x, y,
+			width > 0 ? width : 640, height > 0 ? height : 480, 0,
+			BlackPixel(client_display_, screen), WhitePixel(client_display_, screen));
+		XSync(client_display_, False); // the WM queries it on its own connection
+		map_[w] = replay;
+		++clients_created_;
+		return replay;
+	}
+
+	void alias(Window recorded, Window replay)
+	{
+		if(recorded != None && replay != None)
+			map_[recorded] = replay;
+	}
+
+	unsigned long clients_created_ = 0;
+
+private:
+	Display* client_display_;
+	const Window recorded_root_;
+	const Window root_;
+	::std::unordered_map<Window, Window> map_;
+};
+
+/*-------------------------------------------------------------------
+ * Function: translateEvent
+ * - rewrites every window field of e that the WM looks at.
+ *-------------------------------------------------------------------*/
+static void translateEvent(WindowTranslator& windows, XEvent& e)
+{
+	e.xany.display = nullptr;
+	switch(e.type)
+	{
+	case CreateNotify:
+		e.xcreatewindow.parent = windows.translate(e.xcreatewindow.parent);
+		e.xcreatewindow.window = windows.client(e.xcreatewindow.window,
+			e.xcreatewindow.x, e.xcreatewindow.y,
+			e.xcreatewindow.width, e.xcreatewindow.height);
+		break;
+	case MapRequest:
+		e.xmaprequest.parent = windows.translate(e.xmaprequest.parent);
+		e.xmaprequest.window = windows.client(e.xmaprequest.window, 0, 0, 0, 0);
+		break;
+	case ConfigureRequest:
+		e.xconfigurerequest.parent = windows.translate(e.xconfigurerequest.parent);
+		e.xconfigurerequest.window = windows.client(e.xconfigurerequest.window,
+			e.xconfigurerequest.x, e.xconfigurerequest.y,
+			e.xconfigurerequest.width, e.xconfigurerequest.height);
+		e.xconfigurerequest.above = windows.translate(e.xconfigurerequest.above);
+		break;
+	case DestroyNotify:
+		e.xdestroywindow.event = windows.translate(e.xdestroywindow.event);
+		e.xdestroywindow.window = windows.translate(e.xdestroywindow.window);
+		break;
+	case UnmapNotify:
+		e.xunmap.event = windows.translate(e.xunmap.event);
+		e.xunmap.window = windows.translate(e.xunmap.window);
+		break;
+	case MapNotify:
+		e.xmap.event = windows.translate(e.xmap.event);
+		e.xmap.window = windows.translate(e.xmap.window);
+		break;
+	case ReparentNotify:
+		e.xreparent.event = windows.translate(e.xreparent.event);
+		e.xreparent.window = windows.translate(e.xreparent.window);
+		e.xreparent.parent = windows.translate(e.xreparent.parent);
+		break;
+	case ConfigureNotify:
+		e.xconfigure.event = windows.translate(e.xconfigure.event);
+		e.xconfigure.window = windows.translate(e.xconfigure.window);
+		e.xconfigure.above = windows.translate(e.xconfigure.above);
+		break;
+	case ButtonPress:
+	case ButtonRelease:
+		e.xbutton.window = windows.translate(e.xbutton.window);
+		e.xbutton.root = windows.translate(e.xbutton.root);
+		e.xbutton.subwindow = windows.translate(e.xbutton.subwindow);
+		break;
+	case MotionNotify:
+		e.xmotion.window = windows.translate(e.xmotion.window);
+		e.xmotion.root = windows.translate(e.xmotion.root);
+		e.xmotion.subwindow = windows.translate(e.xmotion.subwindow);
+		break;
+	case KeyPress:
+	case KeyRelease:
+		e.xkey.window = windows.translate(e.xkey.window);
+		e.xkey.root = windows.translate(e.xkey.root);
+		e.xkey.subwindow = windows.translate(e.xkey.subwindow);
+		break;
+	default:
+		e.xany.window = windows.translate(e.xany.window);
+	}
+}
+
+static int dump(const EventTraceReader& trace)
+{
+	const uint64_t start_ns = trace.size() ? trace[0].time_ns_ : 0;
+	for(uint64_t i = 0; i < trace.size(); ++i)
+	{
+		const EventTraceRecord& record = trace[i];
+		printf("%8llu %12.3f ms  ", static_cast<unsigned long long>(i),
+			(record.time_ns_ - start_ns) / 1e6);
+		if(record.kind_ == EventTraceKind::Framed)
+			printf("Framed application %lu frame %lu border %lu buttons %lu %lu %lu\n",
+				record.framed_[0], record.framed_[1], record.framed_[2],
+				record.framed_[3], record.framed_[4], record.framed_[5]);
+		else if(record.kind_ == EventTraceKind::BatchEnd)
+			printf("BatchEnd\n");
+		else
+			printf("%s\n", ToString(record.event_).c_str());
+	}
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+	::google::InitGoogleLogging(argv[0]);
+
+	const bool dump_only = argc > 2 && strcmp(argv[1], "--dump") == 0;
+	if(argc != (dump_only ? 3 : 2))
+	{
+		fprintf(stderr, "usage: swim_replay [--dump] TRACE\n");
+		return EXIT_FAILURE;
+	}
+
+	EventTraceReader trace;
+	if(!trace.open(argv[argc - 1]))
+		return EXIT_FAILURE;
+	if(dump_only)
+		return dump(trace);
+
+	Display* client_display = XOpenDisplay(nullptr);
+	/** Every recreated client comes from client_display, one X client, and
+	 *  the replay runs faster than the recording, so throttling would hold
+	 *  back most maps and configures (and nothing here waits for it). **/
+	Config config = Config::FromEnvironment();
+	config.configure_rate_ = 0;
+	config.map_rate_ = 0;
+	::std::unique_ptr<WindowManager> wm = WindowManager::Create(::std::string(), config);
+	if(client_display == nullptr || !wm)
+	{
+		fprintf(stderr, "swim_replay: failed to open X display %s\n", XDisplayName(nullptr));
+		return EXIT_FAILURE;
+	}
+	XSetErrorHandler(&countXError);
+
+	WindowTranslator windows(client_display, trace.root());
+	uint64_t replay_ns = 0;
+
+	// Framed records are written while their batch is dispatched, so
+	// they are aliased once that batch has run
+	::std::vector<const EventTraceRecord*> framed;
+	auto runBatch = [&] () {
+		const uint64_t start_ns = EventStats::Now();
+		const int dispatched = wm->dispatchQueued();
+		wm->endBatch();
+		replay_ns += EventStats::Now() - start_ns;
+
+		for(const EventTraceRecord* record: framed)
+		{
+			const WindowIndexEntry* entry =
+				wm->window_index_.find(windows.translate(record->framed_[0]));
+			const XLib_Window* client = entry ? wm->clients_.get(entry->handle_) : nullptr;
+			if(client)
+			{
+				windows.alias(record->framed_[1], client->frame_);
+				windows.alias(record->framed_[2], client->border_.border_window_);
+				windows.alias(record->framed_[3], client->move_button_.button_window_);
+				windows.alias(record->framed_[4], client->resize_button_.button_window_);
+				windows.alias(record->framed_[5], client->close_button_.button_window_);
+			}
+		}
+		framed.clear();
+		return dispatched;
+	};
+
+	for(uint64_t i = 0; i < trace.size(); ++i)
+	{
+		const EventTraceRecord& record = trace[i];
+		if(record.kind_ == EventTraceKind::Framed)
+			framed.push_back(&record);
+		else if(record.kind_ == EventTraceKind::BatchEnd)
+			runBatch();
+		else
+		{
+			XEvent e = record.event_;
+			translateEvent(windows, e);
+			wm->queueEvent(e);
+		}
+	}
+
+	// an unterminated last batch, and client events it still defers
+	while(runBatch() > 0)
+		;
+
+	const uint64_t num_events = wm->event_stats_.events_total_;
+	printf("%s\n", wm->event_stats_.toString().c_str());
+
+	// closing the WM's connection flushes it and collects the last errors
+	wm.reset();
+
+	printf("replayed %llu events in %.3f ms (%.0f events/sec), %lu clients recreated, %lu X errors\n",
+		static_cast<unsigned long long>(num_events), replay_ns / 1e6,
+		replay_ns ? num_events * 1e9 / replay_ns : 0.0,
+		windows.clients_created_, x_errors);
+
+	XCloseDisplay(client_display);
+	return EXIT_SUCCESS;
+}
@@ -1,9 +1,11 @@
 #include "util.hpp"
 #include <algorithm>
+#include <cstdarg>
+#include <cstdio>
 #include <sstream>
 #include <vector>
 
-::std::string ToString(const XEvent& e)
+const char* XEventTypeToString(int type)
 {
 	//https://tronche.com/gui/x/xlib/events/types.html
 	static const char* const X_EVENT_TYPE_NAMES[] = 
@@ -46,107 +48,167 @@
 								"GeneralEvent",
 	};
 
+	if (type < 2 || type >= LASTEvent)
+		return "Unknown";
+	return X_EVENT_TYPE_NAMES[type];
+}
+
+/*-------------------------------------------------------------------
+ * Struct: EventFormatter
+ * - appends "name: value" fields to a caller's buffer with snprintf,
+ *   truncating (but always terminating) when it runs out of room.
+ *-------------------------------------------------------------------*/
+struct EventFormatter
+{
+	char* buffer_;
+	::std::size_t size_;
+	::std::size_t length_;
+	bool first_field_;
+
+	void append(const char* format, ...) __attribute__((format(printf, 2, 3)))
+	{
+		if(length_ + 1 >= size_)
+			return;
+		va_list args;
+		va_start(args, format);
+		const int written = vsnprintf(buffer_ + length_, size_ - length_, format, args);
+		va_end(args);
+		if(written > 0)
+			length_ = ::std::min(length_ + written, size_ - 1);
+	}
+
+	void field(const char* name)
+	{
+		append(first_field_ ? "%s: " : ", %s: ", name);
+		first_field_ = false;
+	}
+	void window(const char* name, Window w)			{ field(name); append("%lu", w); }
+	void number(const char* name, long value)		{ field(name); append("%ld", value); }
+	void flag(const char* name, bool value)			{ field(name); append("%d", value ? 1 : 0); }
+	void size(int width, int height)				{ field("size"); append("%dx%d", width, height); }
+	void position(const char* name, int x, int y)	{ field(name); append("(%d, %d)", x, y); }
+	void valueMask(unsigned long value_mask)
+	{
+		static const struct { unsigned long bit_; const char* name_; } BITS[] = {
+			{ CWX, "X" }, { CWY, "Y" }, { CWWidth, "Width" }, { CWHeight, "Height" },
+			{ CWBorderWidth, "BorderWidth" }, { CWSibling, "Sibling" }, { CWStackMode, "StackMode" } };
+
+		field("value_mask");
+		bool first = true;
+		for(const auto& bit: BITS)
+		{
+			if(!(value_mask & bit.bit_))
+				continue;
+			append(first ? "%s" : "|%s", bit.name_);
+			first = false;
+		}
+	}
+};
+
+::std::size_t FormatXEvent(const XEvent& e, char* buffer, ::std::size_t size)
+{
+	if(size == 0)
+		return 0;
+	EventFormatter out = { buffer, size, 0, true };
+	buffer[0] = '\0';
+
 	if (e.type < 2 || e.type >= LASTEvent)
 	{
-		::std::ostringstream out;
-		out << "Unknown (" << e.type << ")";
-		return out.str();
+		out.append("Unknown (%d)", e.type);
+		return out.length_;
 	}
 
 	// Compile properties we care about. 
-
-	::std::vector<::std::pair<::std::string, ::std::string>> properties;
+	out.append("%s {", XEventTypeToString(e.type));
 	switch(e.type)
 	{
 	case CreateNotify:
-		properties.emplace_back("window", ToString(e.xcreatewindow.window));
-		properties.emplace_back("parent", ToString(e.xcreatewindow.parent));
-		properties.emplace_back("size", Size<int>(e.xcreatewindow.width, e.xcreatewindow.height).ToString());
-		properties.emplace_back("position", Position<int>(e.xcreatewindow.x, e.xcreatewindow.y).ToString());
-		properties.emplace_back("border_width", ToString(e.xcreatewindow.border_width));
-		properties.emplace_back("override_redirect", ToString(static_cast<bool>(e.xcreatewindow.override_redirect)));
+		out.window("window", e.xcreatewindow.window);
+		out.window("parent", e.xcreatewindow.parent);
+		out.size(e.xcreatewindow.width, e.xcreatewindow.height);
+		out.position("position", e.xcreatewindow.x, e.xcreatewindow.y);
+		out.number("border_width", e.xcreatewindow.border_width);
+		out.flag("override_redirect", e.xcreatewindow.override_redirect);
 		break;
 
 	case DestroyNotify:
-		properties.emplace_back("window", ToString(e.xdestroywindow.window));
+		out.window("window", e.xdestroywindow.window);
 		break;
 
 	case MapNotify:
-		properties.emplace_back("window", ToString(e.xmap.window));
-		properties.emplace_back("event", ToString(e.xmap.event));
-		properties.emplace_back("override_redirect", ToString(static_cast<bool>(e.xmap.override_redirect)));
+		out.window("window", e.xmap.window);
+		out.window("event", e.xmap.event);
+		out.flag("override_redirect", e.xmap.override_redirect);
 		break;
 
 	case UnmapNotify:
-		properties.emplace_back("window", ToString(e.xunmap.window));
-		properties.emplace_back("event", ToString(e.xunmap.event));
-		properties.emplace_back("from_configure", ToString(static_cast<bool>(e.xunmap.from_configure)));
+		out.window("window", e.xunmap.window);
+		out.window("event", e.xunmap.event);
+		out.flag("from_configure", e.xunmap.from_configure);
 		break;
 
 	case ConfigureNotify:
-		properties.emplace_back("window", ToString(e.xconfigure.window));
-		properties.emplace_back("size", Size<int>(e.xconfigure.width, e.xconfigure.height).ToString());
-		properties.emplace_back("position", Position<int>(e.xconfigure.x, e.xconfigure.y).ToString());
-		properties.emplace_back("border_width", ToString(e.xconfigure.border_width));
-		properties.emplace_back("override_redirect", ToString(static_cast<bool>(e.xconfigure.override_redirect)));
+		out.window("window", e.xconfigure.window);
+		out.size(e.xconfigure.width, e.xconfigure.height);
+		out.position("position", e.xconfigure.x, e.xconfigure.y);
+		out.number("border_width", e.xconfigure.border_width);
+		out.flag("override_redirect", e.xconfigure.override_redirect);
 		break;
 
 	case ReparentNotify:
-		properties.emplace_back("window", ToString(e.xreparent.window));
-		properties.emplace_back("parent", ToString(e.xreparent.parent));
-		properties.emplace_back("position", Position<int>(e.xreparent.x, e.xreparent.y).ToString());
-		properties.emplace_back("override_redirect", ToString(static_cast<bool>(e.xreparent.override_redirect)));
+		out.window("window", e.xreparent.window);
+		out.window("parent", e.xreparent.parent);
+		out.position("position", e.xreparent.x, e.xreparent.y);
+		out.flag("override_redirect", e.xreparent.override_redirect);
 		break;
 
 	case MapRequest:
-		properties.emplace_back("window", ToString(e.xmaprequest.window));
+		out.window("window", e.xmaprequest.window);
 		break;
 
 	case ConfigureRequest:
-		properties.emplace_back("window", ToString(e.xconfigurerequest.window));
-		properties.emplace_back("parent", ToString(e.xconfigurerequest.parent));
-		properties.emplace_back("value_mask", XConfigureWindowValueMaskToString(e.xconfigurerequest.value_mask));
-		properties.emplace_back("position", Position<int>(e.xconfigurerequest.x, e.xconfigurerequest.y).ToString());
-		properties.emplace_back("size", Size<int>(e.xconfigurerequest.width, e.xconfigurerequest.height).ToString());
-		properties.emplace_back("border_width", ToString(e.xconfigurerequest.border_width));
+		out.window("window", e.xconfigurerequest.window);
+		out.window("parent", e.xconfigurerequest.parent);
+		out.valueMask(e.xconfigurerequest.value_mask);
+		out.position("position", e.xconfigurerequest.x, e.xconfigurerequest.y);
+		out.size(e.xconfigurerequest.width, e.xconfigurerequest.height);
+		out.number("border_width", e.xconfigurerequest.border_width);
 		break;
 
 	case ButtonPress:
 	case ButtonRelease:
-		properties.emplace_back("window", ToString(e.xbutton.window));
-		properties.emplace_back("button", ToString(e.xbutton.button));
-		properties.emplace_back("position_root", Position<int>(e.xbutton.x_root, e.xbutton.y_root).ToString());
+		out.window("window", e.xbutton.window);
+		out.number("button", e.xbutton.button);
+		out.position("position_root", e.xbutton.x_root, e.xbutton.y_root);
 		break;
 
 	case MotionNotify:
-		properties.emplace_back("window", ToString(e.xmotion.window));
-		properties.emplace_back("position_root", Position<int>(e.xmotion.x_root, e.xmotion.y_root).ToString());
-		properties.emplace_back("state", ToString(e.xmotion.state));
-		properties.emplace_back("time", ToString(e.xmotion.time));
+		out.window("window", e.xmotion.window);
+		out.position("position_root", e.xmotion.x_root, e.xmotion.y_root);
+		out.number("state", e.xmotion.state);
+		out.number("time", e.xmotion.time);
 		break;
 
 	case KeyPress:
 	case KeyRelease:
-		properties.emplace_back("window", ToString(e.xkey.window));
-		properties.emplace_back("state", ToString(e.xkey.state));
-		properties.emplace_back("keycode", ToString(e.xkey.keycode));
+		out.window("window", e.xkey.window);
+		out.number("state", e.xkey.state);
+		out.number("keycode", e.xkey.keycode);
 		break;
 
 	default:
 		// no properties are printer for unused events
 		break;
 	}
+	out.append(" }");
+	return out.length_;
+}
 
-	// Build final string
-	const ::std::string properties_string = 
-		Join(properties, ", ", [] (const ::std::pair<::std::string, ::std::string> &pair) 
-		{
-			return pair.first + ": " + pair.second;
-		});
-
-	::std::ostringstream out;
-	out << X_EVENT_TYPE_NAMES[e.type] << " {" << properties_string << " }";
-	return out.str();
+::std::string ToString(const XEvent& e)
+{
+	char buffer[XEVENT_STRING_SIZE];
+	const ::std::size_t length = FormatXEvent(e, buffer, sizeof(buffer));
+	return ::std::string(buffer, length);
 }
 
 ::std::string XConfigureWindowValueMaskToString(unsigned long value_mask)
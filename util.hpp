@@ -4,6 +4,7 @@
 extern "C" {
 	#include <X11/Xlib.h>
 }
+#include <cstddef>
 #include <sstream>
 #include <string>
 
@@ -111,12 +112,27 @@ template <typename Container, typename Converter>
 template <typename T>
 ::std::string ToString(const T& x);
 
+/*-----------------------------------------------
+ * Function: XEventTypeToString
+ * - returns the name of an XEvent type ("Unknown" if out of range)
+ *-----------------------------------------------*/
+extern const char* XEventTypeToString(int type);
+
 /*-----------------------------------------------
  * Function: ToString (For XEvent)
  * - returns string of XEvent (for debugging purposes)
  *-----------------------------------------------*/
 extern ::std::string ToString(const XEvent& e);
 
+/*-----------------------------------------------
+ * Function: FormatXEvent
+ * - writes the ToString(XEvent) text into buffer without allocating,
+ *   truncated to fit. Returns the length written (excluding the '\0').
+ * - XEVENT_STRING_SIZE is enough for every event it formats.
+ *-----------------------------------------------*/
+static const ::std::size_t XEVENT_STRING_SIZE = 256;
+extern ::std::size_t FormatXEvent(const XEvent& e, char* buffer, ::std::size_t size);
+
 /*-----------------------------------------------
  * Function: XConfigureWindowValueMaskToString
  * - returns a string describing the X window configuration value mask
@@ -0,0 +1,75 @@
+/*-------------------------------------------------------------------
+ * window_index_bench
+ * - lookup cost of XLib_WindowIndex against the std::unordered_map
+ *   it replaced, at 10, 1,000 and 100,000 managed windows.
+ * - window ids are laid out like real XIDs: six sequential ids (the
+ *   windows of one client) per client resource base.
+ *-------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "event_stats.hpp"
+#include "xlib_window_index.hpp"
+
+static const unsigned int NUM_LOOKUPS = 10000000;
+
+// keeps the lookups from being optimised away
+uint64_t lookup_checksum = 0;
+
+static ::std::vector<Window> makeWindowIds(unsigned int count)
+{
+	::std::vector<Window> ids;
+	for(unsigned int i = 0; i < count; ++i)
+		ids.push_back((static_cast<Window>(i / 6 + 1) << 21) | (i % 6 + 1));
+	return ids;
+}
+
+template <typename Lookup>
+static double timeLookups(const ::std::vector<Window>& probes, Lookup lookup)
+{
+	uint64_t found = 0;
+	const uint64_t start_ns = EventStats::Now();
+	for(unsigned int i = 0; i < NUM_LOOKUPS; ++i)
+		found += lookup(probes[i % probes.size()]);
+	const uint64_t elapsed_ns = EventStats::Now() - start_ns;
+
+	lookup_checksum += found;
+	return static_cast<double>(elapsed_ns) / NUM_LOOKUPS;
+}
+
+int main()
+{
+	printf("windows,structure,hit_ns,miss_ns\n");
+
+	for(unsigned int count: { 10u, 1000u, 100000u })
+	{
+		const ::std::vector<Window> ids = makeWindowIds(count);
+
+		XLib_WindowIndex index;
+		::std::unordered_map<Window, ClientHandle> map;
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			index.insert(ids[i], ClientHandle{ i / 6, 0 }, WindowRole::Application);
+			map[ids[i]] = ClientHandle{ i / 6, 0 };
+		}
+
+		// probe in random order, as events for different clients interleave
+		::std::vector<Window> hits(ids);
+		::std::shuffle(hits.begin(), hits.end(), ::std::mt19937(42));
+		::std::vector<Window> misses;
+		for(Window w: hits)
+			misses.push_back(w | 0x100000);
+
+		auto index_lookup = [&] (Window w) { return index.find(w) != nullptr; };
+		auto map_lookup = [&] (Window w) { return map.find(w) != map.end(); };
+
+		printf("%u,XLib_WindowIndex,%.2f,%.2f\n", count,
+			timeLookups(hits, index_lookup), timeLookups(misses, index_lookup));
+		printf("%u,std::unordered_map,%.2f,%.2f\n", count,
+			timeLookups(hits, map_lookup), timeLookups(misses, map_lookup));
+	}
+	return 0;
+}
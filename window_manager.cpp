@@ -2,6 +2,9 @@
 
 bool WindowManager::wm_detected_;
 ::std::mutex WindowManager::wm_detected_mutex_;
+volatile ::std::sig_atomic_t WindowManager::dump_stats_requested_ = 0;
+volatile ::std::sig_atomic_t WindowManager::span_toggle_requested_ = 0;
+int WindowManager::signal_pipe_[2] = { -1, -1 };
 
 /*------------------------------------------------------------------- 
  * Function: Create
@@ -12,7 +15,7 @@ bool WindowManager::wm_detected_;
  * 					The object is disposed when the uniqie pointer 
  * 					leaves the scope. 
  *-------------------------------------------------------------------*/
-::std::unique_ptr<WindowManager> WindowManager::Create(const ::std::string& display_str)
+::std::unique_ptr<WindowManager> WindowManager::Create(const ::std::string& display_str, const Config& config)
 {	
 
 	const char* display_c_str = display_str.empty() ? nullptr : display_str.c_str();
@@ -28,7 +31,7 @@ bool WindowManager::wm_detected_;
 		return nullptr;
 	}
 	
-	return ::std::unique_ptr<WindowManager>(new WindowManager(display));
+	return ::std::unique_ptr<WindowManager>(new WindowManager(display, config));
 } // END OF Create
 
 /** C++ NOTE:
@@ -42,13 +45,63 @@ bool WindowManager::wm_detected_;
  * - This is the constructor for WindowManager
  * - It initiates the display_ and root_ private variabes 
  *-------------------------------------------------------------------*/
-WindowManager::WindowManager(Display* display) 
-		: display_(CHECK_NOTNULL(display)), //initialising display variable before body
-		  root_(DefaultRootWindow(display_)), // initialising root before body
-		  WM_PROTOCOLS(XInternAtom(display_, "WM_PROTOCOLS", false)),
-		  WM_DELETE_WINDOW(XInternAtom(display_, "WM_DELETE_WINDOW", false))
+WindowManager::WindowManager(Display* display, const Config& config) 
+		: config_(config),
+		  display_(CHECK_NOTNULL(display)), //initialising display variable before body
+		  root_(DefaultRootWindow(display_)) // initialising root before body
 {
+	request_stats_.attach(display_);
 
+	// every atom the WM uses, interned in one round-trip
+	const char* atom_names[] = { 
+		"WM_PROTOCOLS", 
+		"WM_DELETE_WINDOW", 
+		"_NET_WM_SYNC_REQUEST", 
+		"_NET_WM_SYNC_REQUEST_COUNTER" };
+	Atom atoms[4];
+	X_ROUND_TRIP(XInternAtoms(display_, const_cast<char**>(atom_names), 4, false, atoms));
+
+	WM_PROTOCOLS = atoms[0];
+	WM_DELETE_WINDOW = atoms[1];
+	_NET_WM_SYNC_REQUEST = atoms[2];
+	_NET_WM_SYNC_REQUEST_COUNTER = atoms[3];
+
+	// XSync drives _NET_WM_SYNC_REQUEST resizes, without it they are only paced
+	int sync_error_base, sync_major, sync_minor;
+	sync_available_ = 
+		X_ROUND_TRIP(XSyncQueryExtension(display_, &sync_event_base_, &sync_error_base)) &&
+		X_ROUND_TRIP(XSyncInitialize(display_, &sync_major, &sync_minor));
+	if(!sync_available_)
+		LOG(WARNING) << "XSync extension missing, resizes are not synced to clients";
+
+	scheduler_.input_budget_ = ::std::max(config_.input_budget_, 1u);
+	scheduler_.client_budget_ = ::std::max(config_.client_budget_, 1u);
+	// an alarm releases the next step of a synced resize drag
+	if(sync_available_)
+		scheduler_.addInputType(sync_event_base_ + XSyncAlarmNotify);
+
+	throttle_.setResourceMask(xcb_get_setup(XGetXCBConnection(display_))->resource_id_mask);
+	throttle_.limits_[ClientThrottle::Configure] = { config_.configure_rate_, config_.configure_burst_ };
+	throttle_.limits_[ClientThrottle::Map] = { config_.map_rate_, config_.map_burst_ };
+	throttle_timer_ = loop_.addTimer([this] (uint64_t now) {
+		applyDeferred(now);
+		stacking_.restack(display_);
+	});
+
+	drag_.setRefreshRate(config_.drag_refresh_hz_);
+	drag_timer_ = loop_.addTimer([this] (uint64_t now) {
+		if(drag_.due(now))
+			applyDrag();
+		armDragTimer();
+	});
+	outline_.drawn_ = false;
+	cycle_.active_ = false;
+
+	if(!config_.trace_path_.empty())
+		trace_.open(config_.trace_path_, root_);
+	if(!config_.event_log_path_.empty() && !event_log_.open(config_.event_log_path_))
+		LOG(ERROR) << "Cannot open event log " << config_.event_log_path_;
+	resources_.decoration_pool_.high_water_mark_ = config_.decoration_pool_size_;
 }// END OF Constructor 
 
 
@@ -58,7 +111,14 @@ WindowManager::WindowManager(Display* display)
  *-------------------------------------------------------------------*/
 WindowManager::~WindowManager()
 {
+	resources_.free(display_);
 	XCloseDisplay(display_);
+	for(int& fd: signal_pipe_)
+	{
+		if(fd >= 0)
+			close(fd);
+		fd = -1;
+	}
 }// END OF Destructor
 
 /*-------------------------------------------------------------------
@@ -72,6 +132,7 @@ void WindowManager::run()
 	* - if (yes) -> LOG error and gracefully close. 
 	* - if (no) -> Initialisation & Start the main event loop.
 	**/
+	const XRequestStats::Mark startup = request_stats_.mark(display_);
 	wm_detected_ = false;
 	XSetErrorHandler(&WindowManager::OnWMDetected);
 	/** ^ This specifies program supplied error handler. 
@@ -84,7 +145,7 @@ void WindowManager::run()
 	 *  specified event mask. 
 	 *  ( We've chosen the substructure redirect mask and notify mask )
 	 **/
-	XSync(display_, false);
+	X_ROUND_TRIP(XSync(display_, false));
 	/** XSync is configured not to discard events in the queue.
 	 **/
 
@@ -104,121 +165,446 @@ void WindowManager::run()
 	 * OnXError handler
 	 **/
 
+	// the signal handlers wake loop_ through the pipe, so a signal that
+	// lands just before poll() is not left waiting for the next event
+	if(pipe2(signal_pipe_, O_NONBLOCK | O_CLOEXEC) == 0)
+		loop_.addFd(signal_pipe_[0], POLLIN, [] (short) {
+			char drained[64];
+			while(read(signal_pipe_[0], drained, sizeof(drained)) > 0) {}
+		});
+	else
+		LOG(WARNING) << "Cannot create the signal pipe, signals wait for the next event";
+	::std::signal(SIGUSR1, &WindowManager::OnDumpStats);
+	::std::signal(SIGUSR2, &WindowManager::OnToggleSpans);
+
+	adoptExistingWindows();
+	prefillDecorationPool();
+	request_stats_.recordStartup(display_, startup);
+
+	// (2) Main Event loop
+	/**
+	 * Events are handled in batches: everything Xlib has queued or can
+	 * read without blocking is dispatched, then the requests the handlers
+	 * made go out in one XFlush. Only when there is nothing to do does the
+	 * loop sleep, in poll() on the connection, the loop's extra fds and
+	 * its nearest timer.
+	 **/
+	for (;;) // Infinite loop
+	{
+		const int queued = XEventsQueued(display_, QueuedAfterReading);
+		if(queued > 0 || scheduler_.pending())
+			dispatchBatch(queued);
+		else
+		{
+			// a flush that blocked on a full socket may have read events
+			// in meanwhile, only sleep if it did not
+			if(XEventsQueued(display_, QueuedAfterFlush) == 0)
+				loop_.wait(ConnectionNumber(display_));
+		}
+
+		handleSignalRequests();
+	}// END for
+}// END run
+
+/*-------------------------------------------------------------------
+ * Function: dispatchBatch
+ * - count events are taken off Xlib's queue (all of them, so XNextEvent
+ *   never blocks here); client events a previous batch deferred are
+ *   still in scheduler_.
+ * - ends with endBatch(): one flush for every request of the batch.
+ *-------------------------------------------------------------------*/
+void WindowManager::dispatchBatch(int count)
+{
+	XEvent e;
+	for(int i = 0; i < count; ++i)
+	{
+		XNextEvent(display_, &e);
+		queueEvent(e);
+	}
+
+	dispatchQueued();
+	endBatch();
+}
+
+/*-------------------------------------------------------------------
+ * Function: queueEvent
+ * - events are traced as received, before the scheduler merges or
+ *   reorders them; swim_replay feeds them through the same scheduler.
+ *-------------------------------------------------------------------*/
+void WindowManager::queueEvent(const XEvent& e)
+{
+	if(trace_.isOpen())
+		trace_.append(EventStats::Now(), e);
+	scheduler_.push(e);
+}
+
+/*-------------------------------------------------------------------
+ * Function: dispatchQueued
+ *-------------------------------------------------------------------*/
+int WindowManager::dispatchQueued()
+{
+	XEvent e;
+	scheduler_.startBatch();
+	int dispatched = 0;
+	while(scheduler_.next(e))
+	{
+		event_stats_.recordQueueDepth(QLength(display_) + scheduler_.size());
+		dispatchEvent(e);
+		++dispatched;
+	}
+	event_stats_.recordBatch(dispatched);
+	return dispatched;
+}
+
+/*-------------------------------------------------------------------
+ * Function: endBatch
+ * - timers due by the end of the batch run before the flush, so a drag
+ *   step they apply goes out with it. drag_timer_ is armed here, not
+ *   only when the loop goes idle, so a drag keeps going out while
+ *   clients flood the loop.
+ *-------------------------------------------------------------------*/
+void WindowManager::endBatch()
+{
+	applyDeferred(EventStats::Now());
+	armDragTimer();
+	loop_.runTimers(EventStats::Now());
+	stacking_.restack(display_);
+	if(trace_.isOpen())
+		trace_.appendBatchEnd(EventStats::Now());
+	XFlush(display_);
+}
+
+/*-------------------------------------------------------------------
+ * Function: applyDeferred
+ * - runs at the end of every batch and from throttle_timer_.
+ *-------------------------------------------------------------------*/
+void WindowManager::applyDeferred(uint64_t now_ns)
+{
+	if(pending_configures_.empty() && deferred_maps_.empty())
+		return;
+
+	const XRequestStats::Mark start = request_stats_.mark(display_);
+	uint64_t ready_ns = UINT64_MAX;
+	applyPendingConfigures(now_ns, ready_ns);
+	applyDeferredMaps(now_ns, ready_ns);
+	request_stats_.recordDeferred(display_, start);
+
+	if(ready_ns != UINT64_MAX)
+		loop_.armTimer(throttle_timer_, ready_ns);
+	else
+		loop_.disarmTimer(throttle_timer_);
+}
+
+/*-------------------------------------------------------------------
+ * Function: handleSignalRequests
+ * - the work SIGUSR1/SIGUSR2 asked for, done on the event thread.
+ *-------------------------------------------------------------------*/
+void WindowManager::handleSignalRequests()
+{
+	if(dump_stats_requested_)
+	{
+		dump_stats_requested_ = 0;
+		LOG(INFO) << event_stats_.toString();
+		LOG(INFO) << request_stats_.toString();
+		LOG(INFO) << scheduler_.toString();
+		LOG(INFO) << throttle_.toString();
+		LOG(INFO) << stacking_.toString();
+		LOG(INFO) << resources_.decoration_pool_.toString();
+		if(event_log_.isOpen())
+			LOG(INFO) << event_log_.toString();
+	}
+
+	if(span_toggle_requested_)
+	{
+		span_toggle_requested_ = 0;
+		toggleSpanTrace();
+	}
+}
+
+/*-------------------------------------------------------------------
+ * Function: prefillDecorationPool
+ * - creates decoration sets up to the pool's high water mark, so the
+ *   first clients mapped after startup are framed from the pool.
+ *-------------------------------------------------------------------*/
+void WindowManager::prefillDecorationPool()
+{
+	TRACE_SPAN("WindowManager::prefillDecorationPool");
+	XLib_DecorationPool& pool = resources_.decoration_pool_;
+	while(pool.size() < pool.high_water_mark_)
+	{
+		XLib_Window spare;
+		spare.single_window_ = config_.single_window_decorations_;
+		spare.createDecorations(display_, root_, resources_);
+		pool.give(spare.decorations());
+	}
+	LOG(INFO) << "Prefilled " << pool.toString();
+}
+
+/*-------------------------------------------------------------------
+ * Function: adoptExistingWindows
+ * - frames the top level windows that were mapped before the WM ran.
+ * - every query for every window is issued up front through XCB
+ *   cookies, so the whole set costs one round-trip instead of several
+ *   per window, then the windows are framed in a single pass. This
+ *   keeps the server grab short on desktops with many windows.
+ * - override redirect (menus, tooltips) and unmapped windows are
+ *   left alone, they are not ours to frame.
+ *-------------------------------------------------------------------*/
+void WindowManager::adoptExistingWindows()
+{
+	TRACE_SPAN("WindowManager::adoptExistingWindows");
 	XGrabServer(display_);
 	Window returned_root, returned_parent;
 	Window* top_level_windows;
 	unsigned int num_top_level_windows;
-	CHECK(XQueryTree(
+	CHECK(X_ROUND_TRIP(XQueryTree(
 			display_,
 			root_,
 			&returned_root,
 			&returned_parent,
 			&top_level_windows,
-			&num_top_level_windows));
+			&num_top_level_windows)));
 	CHECK_EQ(returned_root, root_);
 
-/*** FRAMING NON XLIB WINDOWS (BORING OLD WINDOWS) ***/
+	xcb_connection_t* connection = XGetXCBConnection(display_);
+
+	struct Cookies
+	{
+		xcb_get_window_attributes_cookie_t attributes_;
+		xcb_get_geometry_cookie_t geometry_;
+		xcb_get_property_cookie_t name_;
+	};
+
+	/** (a) issue every query **/
+	::std::vector<Cookies> cookies(num_top_level_windows);
+	for(unsigned int i = 0; i < num_top_level_windows; ++i)
+	{
+		const Window w = top_level_windows[i];
+		cookies[i].attributes_ = xcb_get_window_attributes(connection, w);
+		cookies[i].geometry_ = xcb_get_geometry(connection, w);
+		cookies[i].name_ = xcb_get_property(connection, 0, w, 
+			XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 0, 256);
+	}
+
+	/** (b) collect the replies, every one of them must be consumed **/
+	// one wait, the rest of the replies are pipelined behind the first
+	++XRequestStats::round_trips_;
+	::std::vector<::std::pair<Window, XLib_ClientInfo>> adoptable;
 	for(unsigned int i = 0; i < num_top_level_windows; ++i)
 	{
-		XLib_Window window_;
-		window_.frameWindow(display_, root_, top_level_windows[i]);
+		xcb_get_window_attributes_reply_t* attributes = 
+			xcb_get_window_attributes_reply(connection, cookies[i].attributes_, nullptr);
+		xcb_get_geometry_reply_t* geometry = 
+			xcb_get_geometry_reply(connection, cookies[i].geometry_, nullptr);
+		xcb_get_property_reply_t* name = 
+			xcb_get_property_reply(connection, cookies[i].name_, nullptr);
+
+		if(attributes && geometry && 
+			!attributes->override_redirect && 
+			attributes->map_state != XCB_MAP_STATE_UNMAPPED)
+		{
+			XLib_ClientInfo info;
+			info.position_ = Position<int>(geometry->x, geometry->y);
+			info.size_ = Size<int>(geometry->width, geometry->height);
+			if(name && name->format == 8 && xcb_get_property_value_length(name) > 0)
+				info.name_.assign(
+					static_cast<const char*>(xcb_get_property_value(name)),
+					xcb_get_property_value_length(name));
+			else
+				info.name_ = "Window";
+
+			adoptable.emplace_back(top_level_windows[i], info);
+		}
+
+		free(attributes);
+		free(geometry);
+		free(name);
 	}
 
+	/** (c) frame them **/
+	for(const auto& it: adoptable)
+		manageWindow(it.first, &it.second);
+
+	LOG(INFO) << "Adopted " << adoptable.size() << " of " 
+		<< num_top_level_windows << " top level windows";
+
 	XFree(top_level_windows);
 	XUngrabServer(display_);
+}
 
+/*-------------------------------------------------------------------
+ * Function: dispatchEvent
+ * - Wraps the handler call in monotonic clock timing, feeding the
+ *   per event type latency histograms in event_stats_.
+ *-------------------------------------------------------------------*/
+void WindowManager::dispatchEvent(XEvent& e)
+{
+	const uint64_t start_ns = EventStats::Now();
+	const XRequestStats::Mark start_requests = request_stats_.mark(display_);
+	const int type = e.type;
+	TRACE_SPAN(XEventTypeToString(type));
 
-	// (2) Main Event loop
-	for (;;) // Infinite loop
+	if(event_log_.isOpen())
 	{
-		/** 
-         * Fetching the next event
-		 **/
-		XEvent e;
-		XNextEvent(display_, &e); 
-			/** fetch the next event from the display and assign the value of 
-			 *  the event to e 
-			 **/
-
-		/**
-		 * Dispatching the Event
-		 **/
-		switch(e.type) 
-		{
-		// BASIC OPERATIONS
-		case CreateNotify:
-			OnCreateNotify(e.xcreatewindow);
-			break;
-		case DestroyNotify:
-			OnDestroyNotify(e.xdestroywindow);
-			break;
-		case ReparentNotify:
-			OnReparentNotify(e.xreparent);
-			break;
-		case MapNotify:
-			OnMapNotify(e.xmap);
-			break;
-		case UnmapNotify:
-			OnUnmapNotify(e.xunmap);
-			break;
-		case ConfigureNotify:
-			OnConfigureNotify(e.xconfigure);
-			break;
-		case MotionNotify:
-			while(XCheckTypedWindowEvent(
-				display_, e.xmotion.window, MotionNotify, &e)) {}
-			OnMotionNotify(e.xmotion);
-			break;
+		// formatted on the stack, the sink thread does the writing
+		char line[AsyncLogSink::LINE_SIZE];
+		const int prefix = snprintf(line, sizeof(line), "%llu ", 
+			static_cast<unsigned long long>(start_ns));
+		const ::std::size_t length = 
+			prefix + FormatXEvent(e, line + prefix, sizeof(line) - prefix);
+		event_log_.write(line, length);
+	}
 
-		case MapRequest:
-			OnMapRequest(e.xmaprequest);
-			break;
-		case ConfigureRequest:
-			OnConfigureRequest(e.xconfigurerequest);
-			break;
-		
-		case ButtonPress:
-			OnButtonPress(e.xbutton);
-			break;
-		case ButtonRelease:
-			OnButtonRelease(e.xbutton);
-			break;
-		case KeyPress:
-			OnKeyPress(e.xkey);
-			break;
-		case KeyRelease:
-			OnKeyRelease(e.xkey);
-			break;
-		/**
-		 * Interaction with application windows
-		 * - in general, window manager must handle actions initiated by client
-		 *   and users (automatic things, and user interface things...)
-		 * - A window manager communicates with cleint applications via events 
-		 * - actions by users and clients invoke events. 
-		 * 
-		 * - Request Events = events where a client application wants
-		 *   to do something to a window and substructure redirection occurs. 
-		 *   They are called "request events" becuase the window manager has
-		 *   to actually devide to invoke an event.
-		 * 
-		 * - Notify Events = events that are already executed by the X server. 
-		 *   The WM can respond to these events but cannot change that theyve 
-		 *   already happened. 
-		 **/
-		default:
+	switch(e.type) 
+	{
+	// BASIC OPERATIONS
+	case CreateNotify:
+		OnCreateNotify(e.xcreatewindow);
+		break;
+	case DestroyNotify:
+		OnDestroyNotify(e.xdestroywindow);
+		break;
+	case ReparentNotify:
+		OnReparentNotify(e.xreparent);
+		break;
+	case MapNotify:
+		OnMapNotify(e.xmap);
+		break;
+	case UnmapNotify:
+		OnUnmapNotify(e.xunmap);
+		break;
+	case ConfigureNotify:
+		OnConfigureNotify(e.xconfigure);
+		break;
+	case Expose:
+		OnExpose(e.xexpose);
+		break;
+	case MotionNotify:
+		// queued motion was already merged by scheduler_
+		OnMotionNotify(e.xmotion);
+		break;
+
+	case MapRequest:
+		OnMapRequest(e.xmaprequest);
+		break;
+	case ConfigureRequest:
+		OnConfigureRequest(e.xconfigurerequest);
+		break;
+	
+	case ButtonPress:
+		OnButtonPress(e.xbutton);
+		break;
+	case ButtonRelease:
+		OnButtonRelease(e.xbutton);
+		break;
+	case KeyPress:
+		OnKeyPress(e.xkey);
+		break;
+	case KeyRelease:
+		OnKeyRelease(e.xkey);
+		break;
+	/**
+	 * Interaction with application windows
+	 * - in general, window manager must handle actions initiated by client
+	 *   and users (automatic things, and user interface things...)
+	 * - A window manager communicates with cleint applications via events 
+	 * - actions by users and clients invoke events. 
+	 * 
+	 * - Request Events = events where a client application wants
+	 *   to do something to a window and substructure redirection occurs. 
+	 *   They are called "request events" becuase the window manager has
+	 *   to actually devide to invoke an event.
+	 * 
+	 * - Notify Events = events that are already executed by the X server. 
+	 *   The WM can respond to these events but cannot change that theyve 
+	 *   already happened. 
+	 **/
+	default:
+		if(sync_available_ && e.type == sync_event_base_ + XSyncAlarmNotify)
+			OnSyncAlarmNotify(reinterpret_cast<const XSyncAlarmNotifyEvent&>(e));
+		else
 			LOG(WARNING) << "Ignored event";
-		}// END switch
-	}// END for
-}// END run
+	}// END switch
+
+	event_stats_.record(type, EventStats::Now() - start_ns);
+	request_stats_.record(type, display_, start_requests);
+}// END dispatchEvent
+
+/*-------------------------------------------------------------------
+ * Function: OnDumpStats [SIGNAL HANDLER]
+ * - only sets a flag, the dump itself happens on the event loop.
+ *   (kill -USR1 <pid> to dump the stats of a running WM)
+ *-------------------------------------------------------------------*/
+void WindowManager::OnDumpStats(int signal)
+{
+	dump_stats_requested_ = 1;
+	wakeEventLoop();
+}// END OnDumpStats
+
+/*-------------------------------------------------------------------
+ * Function: wakeEventLoop [SIGNAL HANDLER]
+ * - makes the signal pipe readable; only async-signal-safe calls.
+ *-------------------------------------------------------------------*/
+void WindowManager::wakeEventLoop()
+{
+	if(signal_pipe_[1] < 0)
+		return;
+	const int saved_errno = errno;
+	const char byte = 0;
+	const ssize_t written = write(signal_pipe_[1], &byte, 1);
+	(void)written; // a full pipe will wake the loop anyway
+	errno = saved_errno;
+}
+
+/*-------------------------------------------------------------------
+ * Function: OnToggleSpans [SIGNAL HANDLER]
+ * - like OnDumpStats, the toggle itself happens on the event loop.
+ *   (kill -USR2 <pid> starts a span trace, the next one writes it)
+ *-------------------------------------------------------------------*/
+void WindowManager::OnToggleSpans(int signal)
+{
+	span_toggle_requested_ = 1;
+	wakeEventLoop();
+}
+
+/*-------------------------------------------------------------------
+ * Function: toggleSpanTrace
+ * - starts recording spans, or stops and writes them to
+ *   <span_trace_prefix_>-<pid>-<n>.json
+ *-------------------------------------------------------------------*/
+void WindowManager::toggleSpanTrace()
+{
+	if(!SpanTracer::enabled_)
+	{
+		SpanTracer::start();
+		LOG(INFO) << "Span trace started";
+		return;
+	}
+
+	static unsigned int num_traces = 0;
+	::std::ostringstream path;
+	path << config_.span_trace_prefix_ << "-" << getpid() << "-" << num_traces++ << ".json";
+	const ::std::size_t num_spans = SpanTracer::size();
+	if(SpanTracer::stop(path.str()))
+		LOG(INFO) << "Span trace of " << num_spans << " spans (" << SpanTracer::dropped() 
+			<< " dropped) written to " << path.str();
+	else
+		LOG(ERROR) << "Cannot write span trace " << path.str();
+}
 
 /*-------------------------------------------------------------------
  *  Function: Unframe
  *-------------------------------------------------------------------*/
-void WindowManager::Unframe(Window w)
+void WindowManager::Unframe(ClientHandle handle)
 {
-	const XLib_Window frame_ = frame_map_[w];
+	TRACE_SPAN("WindowManager::Unframe");
+	XLib_Window* frame_ = clients_.get(handle);
+	if(frame_ == nullptr)
+		return;
+	const Window w = frame_->application_window_;
+	const Window frame_window = frame_->frame_;
 
-	XUnmapWindow(display_, frame_.frame_);
+	XUnmapWindow(display_, frame_->border_.border_window_);
 	XReparentWindow(
 		display_,
 		w,
@@ -226,10 +612,83 @@ void WindowManager::Unframe(Window w)
 		0,0);
 
 	XRemoveFromSaveSet(display_, w);
-	XDestroyWindow(display_, frame_.frame_);
-	frame_map_.erase(w);
+	stacking_.remove(handle);
+	mru_.remove(clients_, handle);
+	if(frame_->sync_.alarm_ != None)
+		XSyncDestroyAlarm(display_, frame_->sync_.alarm_);
+	// the decorations are kept for the next client if the pool has room,
+	// otherwise destroying the border takes frame_ and the buttons with it
+	if(!resources_.decoration_pool_.give(frame_->decorations()))
+		XDestroyWindow(display_, frame_->border_.border_window_);
 
-	LOG(INFO) << "Unframed window " << w << " [" << frame_.frame_ << "] ";
+	window_index_.erase(w);
+	window_index_.erase(frame_window);
+	window_index_.erase(frame_->border_.border_window_);
+	if(!frame_->single_window_)
+	{
+		window_index_.erase(frame_->move_button_.button_window_);
+		window_index_.erase(frame_->resize_button_.button_window_);
+		window_index_.erase(frame_->close_button_.button_window_);
+	}
+	clients_.destroy(handle);
+
+	LOG(INFO) << "Unframed window " << w << " [" << frame_window << "] ";
+}
+
+/*-------------------------------------------------------------------
+ *  Function: manageWindow
+ *-------------------------------------------------------------------*/
+ClientHandle WindowManager::manageWindow(Window w, const XLib_ClientInfo* info)
+{
+	TRACE_SPAN("WindowManager::manageWindow");
+	const ClientHandle handle = clients_.create();
+	XLib_Window* window_ = clients_.get(handle);
+	window_->single_window_ = config_.single_window_decorations_;
+	if(info)
+		window_->frameWindow(display_, root_, w, *info, resources_);
+	else
+		window_->frameWindow(display_, root_, w, resources_);
+
+	stacking_.insert(handle, window_->border_.border_window_);
+	// only focusClient() makes a client the most recent
+	mru_.append(clients_, handle);
+	window_index_.insert(w, handle, WindowRole::Application);
+	window_index_.insert(window_->frame_, handle, WindowRole::Frame);
+	window_index_.insert(window_->border_.border_window_, handle, WindowRole::Border);
+	if(!window_->single_window_)
+	{
+		window_index_.insert(window_->move_button_.button_window_, handle, WindowRole::MoveButton);
+		window_index_.insert(window_->resize_button_.button_window_, handle, WindowRole::ResizeButton);
+		window_index_.insert(window_->close_button_.button_window_, handle, WindowRole::CloseButton);
+	}
+
+	if(trace_.isOpen())
+	{
+		const Window framed[6] = { 
+			w, 
+			window_->frame_, 
+			window_->border_.border_window_, 
+			window_->move_button_.button_window_, 
+			window_->resize_button_.button_window_, 
+			window_->close_button_.button_window_ };
+		trace_.appendFramed(EventStats::Now(), framed);
+	}
+	return handle;
+}
+
+/*-------------------------------------------------------------------
+ *  Function: findClient
+ *-------------------------------------------------------------------*/
+XLib_Window* WindowManager::findClient(Window w, WindowRole* role, ClientHandle* handle)
+{
+	const WindowIndexEntry* entry = window_index_.find(w);
+	if(entry == nullptr)
+		return nullptr;
+	if(role)
+		*role = entry->role_;
+	if(handle)
+		*handle = entry->handle_;
+	return clients_.get(entry->handle_);
 }
 
 /*-------------------------------------------------------------------
@@ -269,7 +728,9 @@ GC WindowManager::create_gc(Display* display_, Window w)
  *-------------------------------------------------------------------*/
 void WindowManager::OnUnmapNotify(const XUnmapEvent& e)
 {
-	if(!frame_map_.count(e.window))
+	WindowRole role;
+	ClientHandle handle;
+	if(!findClient(e.window, &role, &handle) || role != WindowRole::Application)
 	{
 		LOG(INFO) << "Ignore UnmapNotify for non-client window " 
 				<< e.window;
@@ -281,98 +742,361 @@ void WindowManager::OnUnmapNotify(const XUnmapEvent& e)
 				<< e.window;
 		return;
 	}
-	Unframe(e.window);
+	Unframe(handle);
+}
+/*-------------------------------------------------------------------
+ *  Function: hitTest
+ *  - with single window decorations, pointer events on the border are
+ *    resolved to the painted button under (x, y); any other window
+ *    keeps the role it was indexed with.
+ *-------------------------------------------------------------------*/
+WindowRole WindowManager::hitTest(XLib_Window* window_, WindowRole role, int x, int y)
+{
+	if(role != WindowRole::Border || !window_->single_window_)
+		return role;
+
+	const XLib_Button* button = window_->hitTest(x, y);
+	if(button == &window_->move_button_)
+		return WindowRole::MoveButton;
+	if(button == &window_->resize_button_)
+		return WindowRole::ResizeButton;
+	if(button == &window_->close_button_)
+		return WindowRole::CloseButton;
+	return WindowRole::Border;
 }
 /*-------------------------------------------------------------------
  *  Function: OnButtonPress
  *-------------------------------------------------------------------*/
 void WindowManager::OnButtonPress(const XButtonEvent& e)
 {
-	if(true)
+	WindowRole role;
+	ClientHandle handle;
+	XLib_Window* window_ = findClient(e.window, &role, &handle);
+	if(window_)
+		role = hitTest(window_, role, e.x, e.y);
+	if(window_ && (role == WindowRole::MoveButton || 
+		role == WindowRole::ResizeButton || role == WindowRole::CloseButton))
 	{
-		//XLib_Window window_ = frame_map_[e.window];
-		XLib_Window window_ = button_map_[e.window];
-		Window outer_window_ = window_.border_.border_window_;
+		// outline drags resize once at the end, no need to sync
+		if(role == WindowRole::ResizeButton && !config_.drag_outline_)
+			setupSync(window_);
+		if(role != WindowRole::CloseButton)
+			drag_.begin(handle, role, Position<int>(e.x_root, e.y_root),
+				window_->window_properties_.window_position_,
+				window_->window_properties_.window_size_);
 
-		drag_start_pos_ = Position<int>(e.x_root, e.y_root);
-
-		Window returned_root;
-		int x, y;
-		unsigned width, height, border_width, depth;
-
-		CHECK(XGetGeometry(
-			display_,
-			outer_window_,
-			&returned_root,
-			&x, &y,
-			&width, &height,
-			&border_width,
-			&depth));
-
-		drag_start_frame_pos_ = Position<int>(x, y);
-		drag_start_frame_size_ = Size<int>(width, height);
-
-		XRaiseWindow(display_, window_.border_.border_window_);
+		if(role == WindowRole::CloseButton)
+			stacking_.raise(handle);
+		else
+			focusClient(handle);
 	}
 }
 /*-------------------------------------------------------------------
  *  Function: OnButtonRelease
  *-------------------------------------------------------------------*/
-void WindowManager::OnButtonRelease(const XButtonEvent& e) {}
+void WindowManager::OnButtonRelease(const XButtonEvent& e)
+{
+	if(!drag_.active_)
+		return;
+
+	// the final position is always applied, paced or not
+	drag_.motion(Position<int>(e.x_root, e.y_root));
+	if(config_.drag_outline_)
+	{
+		// the client only ever sees this one move/resize
+		eraseOutline();
+		XLib_Window* window_ = clients_.get(drag_.handle_);
+		if(window_)
+			applyDragGeometry(window_);
+	}
+	else
+		applyDrag();
+	drag_.end();
+	armDragTimer();
+}
 
 /*-------------------------------------------------------------------
  *  Function: OnMotionNotify
  *-------------------------------------------------------------------*/
 void WindowManager::OnMotionNotify(const XMotionEvent& e)
 {
-	//CHECK(clients_.count(e.window));
+	WindowRole role;
+	XLib_Window* window_ = findClient(e.window, &role);
+	if(window_ == nullptr)
+		return;
 
-	//XLib_Window window_ = frame_map_[e.window]; //ISSUE: ASSUMES WINDOW IS AN XLIB_WINDOW...
-	XLib_Window window_ = button_map_[e.window]; 
+	if(!(e.state & Button1Mask))
+	{
+		LOG(INFO) << "Error: Window has no children." << e.window;
+		return;
+	}
 
-	const Position<int> drag_pos(e.x_root, e.y_root);
-	const Vector2D<int> delta = drag_pos - drag_start_pos_;
+	// the border keeps the pointer for the whole drag, wherever it goes
+	if(role == WindowRole::Border && window_->single_window_)
+		role = drag_.active_ ? drag_.role_ : hitTest(window_, role, e.x, e.y);
 
-	if(e.state & Button1Mask) // Moving
+	if(role == WindowRole::CloseButton)
 	{
-		if(e.window == window_.move_button_.button_window_)
-		{
-			const Position<int> dest_frame_pos = drag_start_frame_pos_ + delta;
-			
-			window_.moveWindow(display_, dest_frame_pos.x, dest_frame_pos.y, root_);
-		}
-		else if(e.window == window_.resize_button_.button_window_)
-		{
-			const Vector2D<int> size_delta(
-				std::max(delta.x, -drag_start_frame_size_.width),
-				std::max(delta.y, -drag_start_frame_size_.height));
-			const Size<int> dest_frame_size = drag_start_frame_size_ + size_delta;
+		std::cout << "DOESNT CLOSE WINDOW YET" << std::endl;
+	}
+	else if(drag_.active_ && (role == WindowRole::MoveButton || role == WindowRole::ResizeButton))
+	{
+		// only record the pointer, geometry goes out at most once per interval
+		drag_.motion(Position<int>(e.x_root, e.y_root));
+		if(drag_.due(EventStats::Now()))
+			applyDrag();
+	}
+	// No redraw here, whatever the move/resize uncovered arrives as Expose
+}
 
-			window_.resizeWindow(display_, dest_frame_size.width, dest_frame_size.height, root_);
-		}
-		else if(e.window == window_.close_button_.button_window_)
+/*-------------------------------------------------------------------
+ *  Function: applyDrag
+ *  - sends the geometry implied by the latest drag motion, or in
+ *    outline mode only moves the outline to it.
+ *-------------------------------------------------------------------*/
+void WindowManager::applyDrag()
+{
+	TRACE_SPAN("WindowManager::applyDrag");
+	XLib_Window* window_ = clients_.get(drag_.handle_);
+	if(window_ == nullptr)
+	{
+		eraseOutline();
+		drag_.end(); // client went away mid drag
+		armDragTimer();
+		return;
+	}
+
+	if(config_.drag_outline_)
+	{
+		Position<int> position = window_->window_properties_.window_position_;
+		Size<int> size = window_->window_properties_.window_size_;
+		if(drag_.role_ == WindowRole::MoveButton)
+			position = drag_.targetPosition();
+		else
+			size = drag_.targetSize();
+
+		XRectangle area;
+		area.x = position.x;
+		area.y = position.y;
+		area.width = size.width;
+		area.height = size.height + window_->border_.border_height;
+		drawOutline(area);
+		drag_.applied(EventStats::Now());
+		return;
+	}
+
+	applyDragGeometry(window_);
+}
+
+/*-------------------------------------------------------------------
+ *  Function: armDragTimer
+ *  - runs at the end of every batch and from drag_timer_ itself, which
+ *    may fire before a synced resize is allowed to go out.
+ *-------------------------------------------------------------------*/
+void WindowManager::armDragTimer()
+{
+	if(drag_.pending_)
+		loop_.armTimer(drag_timer_, drag_.deadline());
+	else
+		loop_.disarmTimer(drag_timer_);
+}
+
+/*-------------------------------------------------------------------
+ *  Function: applyDragGeometry
+ *  - moves/resizes the dragged client to the latest drag target.
+ *-------------------------------------------------------------------*/
+void WindowManager::applyDragGeometry(XLib_Window* window_)
+{
+	if(drag_.role_ == WindowRole::MoveButton)
+	{
+		const Position<int> dest_frame_pos = drag_.targetPosition();
+		window_->moveWindow(display_, dest_frame_pos.x, dest_frame_pos.y, root_);
+	}
+	else
+	{
+		const Size<int> dest_frame_size = drag_.targetSize();
+		const bool synced = sendSyncRequest(window_);
+		window_->resizeWindow(display_, dest_frame_size.width, dest_frame_size.height, root_);
+		if(synced)
 		{
-			std::cout << "DOESNT CLOSE WINDOW YET" << std::endl;
+			const uint64_t now = EventStats::Now();
+			drag_.applied(now);
+			drag_.waitForSync(now);
+			return;
 		}
 	}
-	
+	drag_.applied(EventStats::Now());
+}
+
+/*-------------------------------------------------------------------
+ *  Function: drawOutline / eraseOutline
+ *  - the outline is XORed onto the root window, so drawing it again
+ *    erases it. The server stays grabbed while it is shown, otherwise
+ *    clients repainting underneath would leave parts of it behind.
+ *-------------------------------------------------------------------*/
+void WindowManager::drawOutline(const XRectangle& area)
+{
+	TRACE_SPAN("WindowManager::drawOutline");
+	GC gc = resources_.gc_cache_.outline(display_, root_);
+	if(outline_.drawn_)
+		XDrawRectangle(display_, root_, gc, outline_.area_.x, outline_.area_.y, 
+			outline_.area_.width, outline_.area_.height);
 	else
-		LOG(INFO) << "Error: Window has no children." << e.window;
+		XGrabServer(display_);
 
-	redrawAllWindows();
+	XDrawRectangle(display_, root_, gc, area.x, area.y, area.width, area.height);
+	outline_.area_ = area;
+	outline_.drawn_ = true;
 }
 
-void WindowManager::redrawAllWindows()
+void WindowManager::eraseOutline()
 {
-	// traverse frame map
-	for(auto& it: frame_map_)
-	{
-		XLib_Window xlib_window = frame_map_[it.first];
-		xlib_window.border_.createRectangles(display_, root_);
-		xlib_window.close_button_.createRectangles(display_, root_);
-		xlib_window.move_button_.createRectangles(display_, root_);
-		xlib_window.resize_button_.createRectangles(display_, root_);
-	}
+	if(!outline_.drawn_)
+		return;
+
+	XDrawRectangle(display_, root_, resources_.gc_cache_.outline(display_, root_), 
+		outline_.area_.x, outline_.area_.y, outline_.area_.width, outline_.area_.height);
+	XUngrabServer(display_);
+	outline_.drawn_ = false;
+}
+
+/*-------------------------------------------------------------------
+ *  Function: setupSync
+ *  - looks up the client's _NET_WM_SYNC_REQUEST counter (once per
+ *    client) and creates the alarm that reports its updates.
+ *  - costs a few round-trips, so it is only done when a resize drag
+ *    starts, not for every client.
+ *-------------------------------------------------------------------*/
+void WindowManager::setupSync(XLib_Window* window_)
+{
+	TRACE_SPAN("WindowManager::setupSync");
+	if(!sync_available_ || window_->sync_.checked_)
+		return;
+	window_->sync_.checked_ = true;
+
+	const Window w = window_->application_window_;
+	Atom* protocols;
+	int num_protocols;
+	if(!X_ROUND_TRIP(XGetWMProtocols(display_, w, &protocols, &num_protocols)))
+		return;
+	const bool supported = ::std::find(protocols, protocols + num_protocols, 
+		_NET_WM_SYNC_REQUEST) != protocols + num_protocols;
+	XFree(protocols);
+	if(!supported)
+		return;
+
+	Atom type;
+	int format;
+	unsigned long num_items, bytes_after;
+	unsigned char* data = nullptr;
+	if(X_ROUND_TRIP(XGetWindowProperty(display_, w, _NET_WM_SYNC_REQUEST_COUNTER, 0, 1, false, 
+		XA_CARDINAL, &type, &format, &num_items, &bytes_after, &data)) != Success)
+		return;
+	const XSyncCounter counter = (data && num_items == 1 && format == 32) ?
+		*reinterpret_cast<unsigned long*>(data) : None;
+	if(data)
+		XFree(data);
+
+	XSyncValue value;
+	if(counter == None || !X_ROUND_TRIP(XSyncQueryCounter(display_, counter, &value)))
+		return;
+
+	window_->sync_.counter_ = counter;
+	window_->sync_.value_ = 
+		(static_cast<uint64_t>(XSyncValueHigh32(value)) << 32) | XSyncValueLow32(value);
+
+	XSyncAlarmAttributes attrs;
+	attrs.trigger.counter = counter;
+	attrs.trigger.value_type = XSyncAbsolute;
+	attrs.trigger.wait_value = value;
+	attrs.trigger.test_type = XSyncPositiveComparison;
+	XSyncIntToValue(&attrs.delta, 0);
+	attrs.events = True;
+	window_->sync_.alarm_ = XSyncCreateAlarm(display_, 
+		XSyncCACounter | XSyncCAValueType | XSyncCAValue | XSyncCATestType | 
+		XSyncCADelta | XSyncCAEvents, &attrs);
+
+	LOG(INFO) << "Resizes of " << w << " synced on counter " << counter;
+}
+
+/*-------------------------------------------------------------------
+ *  Function: sendSyncRequest
+ *  - asks the client to set its counter to the next value once it has
+ *    handled the resize that follows, and arms the alarm for it.
+ *  - false if the client does not support _NET_WM_SYNC_REQUEST.
+ *-------------------------------------------------------------------*/
+bool WindowManager::sendSyncRequest(XLib_Window* window_)
+{
+	if(window_->sync_.counter_ == None)
+		return false;
+
+	const uint64_t value = ++window_->sync_.value_;
+
+	XSyncAlarmAttributes attrs;
+	XSyncIntsToValue(&attrs.trigger.wait_value, 
+		static_cast<unsigned int>(value & 0xffffffff), static_cast<int>(value >> 32));
+	XSyncChangeAlarm(display_, window_->sync_.alarm_, XSyncCAValue, &attrs);
+
+	XEvent msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.xclient.type 			= ClientMessage;
+	msg.xclient.message_type 	= WM_PROTOCOLS;
+	msg.xclient.window 			= window_->application_window_;
+	msg.xclient.format   		= 32;
+	msg.xclient.data.l[0] 		= _NET_WM_SYNC_REQUEST;
+	msg.xclient.data.l[1] 		= CurrentTime;
+	msg.xclient.data.l[2] 		= value & 0xffffffff;
+	msg.xclient.data.l[3] 		= value >> 32;
+	XSendEvent(display_, window_->application_window_, false, 0, &msg);
+	return true;
+}
+
+/*-------------------------------------------------------------------
+ *  Function: OnSyncAlarmNotify
+ *  - the client has drawn the last synced size, the next (coalesced) one
+ *    can go out now.
+ *-------------------------------------------------------------------*/
+void WindowManager::OnSyncAlarmNotify(const XSyncAlarmNotifyEvent& e)
+{
+	if(!drag_.active_ || !drag_.sync_waiting_)
+		return;
+
+	XLib_Window* window_ = clients_.get(drag_.handle_);
+	if(window_ == nullptr || e.alarm != window_->sync_.alarm_)
+		return;
+
+	const uint64_t counter_value = 
+		(static_cast<uint64_t>(XSyncValueHigh32(e.counter_value)) << 32) | 
+		XSyncValueLow32(e.counter_value);
+	if(counter_value < window_->sync_.value_)
+		return;
+
+	drag_.synced();
+	if(drag_.due(EventStats::Now()))
+		applyDrag();
+}
+
+/*-------------------------------------------------------------------
+ *  Function: OnExpose
+ *  - damage is collected per decoration window until the last Expose
+ *    of the group (count == 0), then only that client is repainted.
+ *-------------------------------------------------------------------*/
+void WindowManager::OnExpose(const XExposeEvent& e)
+{
+	WindowRole role;
+	XLib_Window* window_ = findClient(e.window, &role);
+	if(window_ == nullptr || role == WindowRole::Application || role == WindowRole::Frame)
+		return; // frame_ is only ever filled with its background pixel
+
+	XRectangle area;
+	area.x = e.x;
+	area.y = e.y;
+	area.width = e.width;
+	area.height = e.height;
+	window_->addDamage(e.window, area);
+
+	if(e.count == 0)
+		window_->repaintDamage(display_, root_, resources_);
 }
 
 /*-------------------------------------------------------------------
@@ -380,70 +1104,198 @@ void WindowManager::redrawAllWindows()
  *-------------------------------------------------------------------*/
 void WindowManager::OnKeyPress(const XKeyEvent& e)
 {
+	// while cycling the keyboard is grabbed, only Tab and Escape count
+	if(cycle_.active_)
+	{
+		if(e.keycode == XKeysymToKeycode(display_, XK_Tab))
+			cycleFocus(!(e.state & ShiftMask));
+		else if(e.keycode == XKeysymToKeycode(display_, XK_Escape))
+			endCycle(false);
+		return;
+	}
+
 	// ALT + F4 CLOSING THE WINDOW
 	if((e.state & Mod1Mask) && (e.keycode == XKeysymToKeycode(display_, XK_F4)))
 	{
+		// the key is grabbed on border_window_, the protocols live on the client
+		XLib_Window* window_ = findClient(e.window);
+		const Window w = window_ ? window_->application_window_ : e.window;
+
 		Atom* supported_protocols;
 		int num_supported_protocols;
-		if(XGetWMProtocols(
+		if(X_ROUND_TRIP(XGetWMProtocols(
 			display_,
-			e.window,
+			w,
 			&supported_protocols,
-			&num_supported_protocols) &&
+			&num_supported_protocols)) &&
 		  (::std::find(
 			supported_protocols, 
 			supported_protocols + num_supported_protocols,
 			WM_DELETE_WINDOW) != 
 		  	supported_protocols + num_supported_protocols))
 		{
-			LOG(INFO) << "Gracefully closing the window " << e.window;
+			LOG(INFO) << "Gracefully closing the window " << w;
 			XEvent msg;
 			memset(&msg, 0, sizeof(msg));
 			msg.xclient.type 			= ClientMessage;
 			msg.xclient.message_type 	= WM_PROTOCOLS;
-			msg.xclient.window 			= e.window;
+			msg.xclient.window 			= w;
 			msg.xclient.format   		= 32;
 			msg.xclient.data.l[0] 		= WM_DELETE_WINDOW;
 
-			CHECK(XSendEvent(display_, e.window, false, 0, &msg));
+			CHECK(XSendEvent(display_, w, false, 0, &msg));
 		}
 		else
 		{
-			LOG(INFO) << "Killing Window " << e.window;
-			XKillClient(display_, e.window);
+			LOG(INFO) << "Killing Window " << w;
+			XKillClient(display_, w);
 		}
 	}
 	// ALT + TAB SWITCH WINDOW
 	else if ((e.state & Mod1Mask) &&
 				(e.keycode == XKeysymToKeycode(display_, XK_Tab)))
 	{
-		auto i = frame_map_.find(e.window);
-		CHECK(i != frame_map_.end());
-		++i;
-		if(i == frame_map_.end())
+		cycleFocus(!(e.state & ShiftMask));
+	}
+}
+
+/*-------------------------------------------------------------------
+ *  Function: OnKeyRelease
+ *  - releasing Alt ends an Alt+Tab cycle on the previewed client.
+ *-------------------------------------------------------------------*/
+void WindowManager::OnKeyRelease(const XKeyEvent& e)
+{
+	if(!cycle_.active_)
+		return;
+
+	const KeySym alt_keys[] = { XK_Alt_L, XK_Alt_R, XK_Meta_L, XK_Meta_R };
+	for(KeySym key: alt_keys)
+	{
+		if(e.keycode == XKeysymToKeycode(display_, key))
 		{
-			i = frame_map_.begin();
+			endCycle(true);
+			return;
 		}
+	}
+}
 
-		XRaiseWindow(display_, (i->second).frame_);
-		XSetInputFocus(display_, (i->first), RevertToPointerRoot, CurrentTime);
+/*-------------------------------------------------------------------
+ *  Function: focusClient
+ *-------------------------------------------------------------------*/
+void WindowManager::focusClient(ClientHandle handle)
+{
+	XLib_Window* window_ = clients_.get(handle);
+	if(window_ == nullptr)
+		return;
+
+	stacking_.raise(handle);
+	mru_.touch(clients_, handle);
+	XSetInputFocus(display_, window_->border_.border_window_, RevertToPointerRoot, CurrentTime);
+}
+
+/*-------------------------------------------------------------------
+ *  Function: cycleFocus
+ *  - the cycle walks mru_ from the most recent client, so Alt+Tab
+ *    once goes back to the previous client and holding Alt steps
+ *    further back. Shift walks the other way.
+ *  - focus and mru_ only change on commit, so the order does not
+ *    shift under the cycle.
+ *  - stepping mru_ is O(1); the preview raise is linear in the
+ *    stacked clients, like every raise, and the restack sends all of
+ *    them anyway.
+ *  - Escape restores the stacking order saved when the cycle began,
+ *    undoing every preview.
+ *-------------------------------------------------------------------*/
+void WindowManager::cycleFocus(bool forward)
+{
+	if(!cycle_.active_)
+	{
+		if(mru_.size() < 2)
+			return;
+		// every key, and Alt's release, comes to the WM until the cycle ends
+		if(X_ROUND_TRIP(XGrabKeyboard(display_, root_, false, 
+			GrabModeAsync, GrabModeAsync, CurrentTime)) != GrabSuccess)
+			return;
+
+		cycle_.active_ = true;
+		cycle_.origin_ = mru_.front();
+		cycle_.current_ = cycle_.origin_;
+		// reuses the capacity of the last cycle's copy
+		cycle_.stacking_.assign(stacking_.entries().begin(), stacking_.entries().end());
 	}
+
+	// the previewed client went away, carry on from the most recent one
+	if(clients_.get(cycle_.current_) == nullptr)
+		cycle_.current_ = mru_.front();
+	cycle_.current_ = forward ? 
+		mru_.next(clients_, cycle_.current_) : mru_.prev(clients_, cycle_.current_);
+	stacking_.raise(cycle_.current_);
+
+	// a quick Alt+Tab may be over before the grab, the release is then lost
+	if(!altHeld())
+		endCycle(true);
 }
 
 /*-------------------------------------------------------------------
- *  Function: OnKeyRelease
+ *  Function: endCycle
  *-------------------------------------------------------------------*/
-void WindowManager::OnKeyRelease(const XKeyEvent& e) {}
+void WindowManager::endCycle(bool commit)
+{
+	cycle_.active_ = false;
+	XUngrabKeyboard(display_, CurrentTime);
+	if(commit)
+		focusClient(cycle_.current_);
+	else
+		stacking_.restore(cycle_.stacking_);
+}
+
+/*-------------------------------------------------------------------
+ *  Function: altHeld
+ *-------------------------------------------------------------------*/
+bool WindowManager::altHeld()
+{
+	char keys[32];
+	X_ROUND_TRIP(XQueryKeymap(display_, keys));
+
+	const KeySym alt_keys[] = { XK_Alt_L, XK_Alt_R, XK_Meta_L, XK_Meta_R };
+	for(KeySym key: alt_keys)
+	{
+		const KeyCode code = XKeysymToKeycode(display_, key);
+		if(code && (keys[code / 8] & (1 << (code % 8))))
+			return true;
+	}
+	return false;
+}
 
 /*-------------------------------------------------------------------
  *  Function: OnDestroyNotify
  *-------------------------------------------------------------------*/
-void WindowManager::OnDestroyNotify(const XDestroyWindowEvent& e) {}
+void WindowManager::OnDestroyNotify(const XDestroyWindowEvent& e)
+{
+	// drop what throttle_ still holds back for the window
+	deferred_maps_.erase(::std::remove(deferred_maps_.begin(), deferred_maps_.end(), e.window),
+		deferred_maps_.end());
+	pending_configures_.erase(::std::remove_if(pending_configures_.begin(), pending_configures_.end(),
+		[&e] (const PendingConfigure& pending) { return pending.window_ == e.window; }),
+		pending_configures_.end());
+}
 
 /*-------------------------------------------------------------------
  *  Function: OnConfigureNotify
+ *  - keeps the cached geometry in step with the server, for border
+ *    changes the WM did not make itself.
  *-------------------------------------------------------------------*/
-void WindowManager::OnConfigureNotify(const XConfigureEvent& e) {}
+void WindowManager::OnConfigureNotify(const XConfigureEvent& e)
+{
+	WindowRole role;
+	XLib_Window* window_ = findClient(e.window, &role);
+	if(window_ == nullptr || role != WindowRole::Border)
+		return;
+
+	window_->window_properties_.window_position_ = Position<int>(e.x, e.y);
+	if(e.height >= static_cast<int>(window_->border_.border_height))
+		window_->setSize(e.width, e.height - window_->border_.border_height);
+}
 
 /*-------------------------------------------------------------------
  *  Function: OnReparentNotify
@@ -465,37 +1317,136 @@ void WindowManager::OnCreateNotify(const XCreateWindowEvent& e) {}
 /*-------------------------------------------------------------------
  *  Function: OnConfigureRequest 
  *  - request to the WM to configure a window. 
+ *  - merged into the window's pending request and granted once by
+ *    endBatch(), so a burst of requests costs one configure per batch.
+ *    Each field keeps the last value requested; the last stacking
+ *    request wins (with its sibling, if it named one).
  *-------------------------------------------------------------------*/
 void WindowManager::OnConfigureRequest(const XConfigureRequestEvent& e)
 {
-	if(e.window != root_)
+	if(e.window == root_)
+		return;
+
+	PendingConfigure* pending = nullptr;
+	for(PendingConfigure& it: pending_configures_)
+	{
+		if(it.window_ == e.window)
+		{
+			pending = &it;
+			break;
+		}
+	}
+	if(pending == nullptr)
 	{
-		
-		XLib_Window window_ = frame_map_[e.window];
-		
-		unsigned int window_bar_height_ = 
-			window_.window_properties_.window_bar_height_;
-		
-		XWindowChanges changes;
-		// copy fields from e to changes
+		pending_configures_.push_back(PendingConfigure{ e.window, 0, XWindowChanges() });
+		pending = &pending_configures_.back();
+	}
+
+	XWindowChanges& changes = pending->changes_;
+	if(e.value_mask & CWX)
 		changes.x = e.x;
+	if(e.value_mask & CWY)
 		changes.y = e.y;
+	if(e.value_mask & CWWidth)
 		changes.width = e.width;
+	if(e.value_mask & CWHeight)
 		changes.height = e.height;
+	if(e.value_mask & CWBorderWidth)
 		changes.border_width = e.border_width;
-		changes.sibling = e.above;
+	if(e.value_mask & CWStackMode)
+	{
 		changes.stack_mode = e.detail;
+		changes.sibling = e.above;
+		if(!(e.value_mask & CWSibling))
+			pending->value_mask_ &= ~CWSibling;
+	}
+	pending->value_mask_ |= e.value_mask;
+}
+
+/*-------------------------------------------------------------------
+ *  Function: applyConfigure 
+ *-------------------------------------------------------------------*/
+void WindowManager::applyConfigure(Window w, unsigned long value_mask, XWindowChanges& changes)
+{
+	TRACE_SPAN("WindowManager::applyConfigure");
+	WindowRole role;
+	ClientHandle handle;
+	XLib_Window* window_ = findClient(w, &role, &handle);
+
+	if(window_ && role == WindowRole::Application)
+	{
+		/** Stacking goes through stacking_ (restacked at the end of the
+		 *  batch). Above/Below raise/lower within the client's layer; the
+		 *  sibling and the occlusion dependent modes are not honoured. **/
+		if((value_mask & CWStackMode) && changes.stack_mode == Above)
+			stacking_.raise(handle);
+		else if((value_mask & CWStackMode) && changes.stack_mode == Below)
+			stacking_.lower(handle);
+
+		/** The border carries the position, frame_ and the client only 
+		 *  follow the size. **/
+		XWindowChanges border_changes = changes;
+		border_changes.height = changes.height + window_->border_.border_height;
+		XConfigureWindow(display_, window_->border_.border_window_, 
+			value_mask & (CWX | CWY | CWWidth | CWHeight), &border_changes);
+		XConfigureWindow(display_, window_->frame_, value_mask & (CWWidth | CWHeight), &changes);
+
+		if(value_mask & CWX)
+			window_->window_properties_.window_position_.x = changes.x;
+		if(value_mask & CWY)
+			window_->window_properties_.window_position_.y = changes.y;
+		window_->setSize(
+			(value_mask & CWWidth) ? changes.width : window_->window_properties_.window_size_.width,
+			(value_mask & CWHeight) ? changes.height : window_->window_properties_.window_size_.height);
+		LOG(INFO) << "Resize [" << window_->frame_ << "] to " << Size<int>(changes.width, changes.height);
+
+		value_mask &= ~(CWX | CWY | CWSibling | CWStackMode);
+	}
 
-		if(frame_map_.count(e.window))
+	// grant request by calling XConfigureWindow
+	XConfigureWindow(display_, w, value_mask, &changes);
+	LOG(INFO) << "Resize " << w << " to " << Size<int>(changes.width, changes.height);
+}
+
+/*-------------------------------------------------------------------
+ *  Function: applyPendingConfigures 
+ *  - a request throttle_ refuses stays pending (and keeps merging
+ *    later ones); ready_ns is lowered to when it may go.
+ *  - a window destroyed since its request only costs an ignored 
+ *    BadWindow error.
+ *-------------------------------------------------------------------*/
+void WindowManager::applyPendingConfigures(uint64_t now_ns, uint64_t& ready_ns)
+{
+	::std::size_t kept = 0;
+	for(PendingConfigure& pending: pending_configures_)
+	{
+		uint64_t ready;
+		if(throttle_.admit(ClientThrottle::Configure, pending.window_, now_ns, ready))
+			applyConfigure(pending.window_, pending.value_mask_, pending.changes_);
+		else
 		{
-			XConfigureWindow(display_, window_.border_.border_window_, e.value_mask, &changes);
-			XConfigureWindow(display_, window_.frame_, e.value_mask, &changes);
-			LOG(INFO) << "Resize [" << window_.frame_ << "] to " << Size<int>(e.width, e.height);
+			ready_ns = ::std::min(ready_ns, ready);
+			pending_configures_[kept++] = pending;
 		}
+	}
+	pending_configures_.resize(kept);
+}
 
-		// grant request by calling XConfigureWindow
-		XConfigureWindow(display_, e.window, e.value_mask, &changes);
-		LOG(INFO) << "Resize " << e.window << " to " << Size<int>(e.width, e.height);
+/*-------------------------------------------------------------------
+ *  Function: applyPendingConfigure 
+ *  - grants w's pending request now, for handlers that need the
+ *    geometry the client asked for (e.g. framing it on MapRequest).
+ *-------------------------------------------------------------------*/
+void WindowManager::applyPendingConfigure(Window w)
+{
+	for(auto it = pending_configures_.begin(); it != pending_configures_.end(); ++it)
+	{
+		if(it->window_ == w)
+		{
+			applyConfigure(it->window_, it->value_mask_, it->changes_);
+			pending_configures_.erase(it);
+			return;
+		}
 	}
 }
 
@@ -504,15 +1455,63 @@ void WindowManager::OnConfigureRequest(const XConfigureRequestEvent& e)
  *-------------------------------------------------------------------*/
 void WindowManager::OnMapRequest(const XMapRequestEvent& e)
 {
-	XLib_Window window_;
-	window_.frameWindow(display_, root_, e.window);
+	if(::std::find(deferred_maps_.begin(), deferred_maps_.end(), e.window) != deferred_maps_.end())
+		return;
+
+	// behind an earlier map of the same client that is still waiting
+	const XID client = throttle_.clientOf(e.window);
+	bool waiting = false;
+	for(Window w: deferred_maps_)
+		waiting = waiting || throttle_.clientOf(w) == client;
+
+	uint64_t ready_ns;
+	if(waiting || !throttle_.admit(ClientThrottle::Map, e.window, EventStats::Now(), ready_ns))
+	{
+		deferred_maps_.push_back(e.window);
+		return;
+	}
+	mapClient(e.window);
+}
 
-	frame_map_[window_.border_.border_window_] = window_;
-	button_map_[window_.move_button_.button_window_] = window_; // map the move button
-	button_map_[window_.resize_button_.button_window_] = window_; // map the resize button
-	button_map_[window_.close_button_.button_window_] = window_; // map the close button
+/*-------------------------------------------------------------------
+ *  Function: mapClient 
+ *-------------------------------------------------------------------*/
+void WindowManager::mapClient(Window w)
+{
+	applyPendingConfigure(w);
+	manageWindow(w);
 	// Now map the window 
-	XMapWindow(display_, e.window);
+	XMapWindow(display_, w);
+}
+
+/*-------------------------------------------------------------------
+ *  Function: applyDeferredMaps 
+ *  - in arrival order; once one map of a client is refused, its later
+ *    ones wait too.
+ *-------------------------------------------------------------------*/
+void WindowManager::applyDeferredMaps(uint64_t now_ns, uint64_t& ready_ns)
+{
+	::std::size_t kept = 0;
+	for(::std::size_t i = 0; i < deferred_maps_.size(); ++i)
+	{
+		const Window w = deferred_maps_[i];
+		const XID client = throttle_.clientOf(w);
+		bool waiting = false;
+		for(::std::size_t j = 0; j < kept; ++j)
+			waiting = waiting || throttle_.clientOf(deferred_maps_[j]) == client;
+
+		uint64_t ready;
+		if(waiting)
+			deferred_maps_[kept++] = w;
+		else if(throttle_.admit(ClientThrottle::Map, w, now_ns, ready))
+			mapClient(w);
+		else
+		{
+			ready_ns = ::std::min(ready_ns, ready);
+			deferred_maps_[kept++] = w;
+		}
+	}
+	deferred_maps_.resize(kept);
 }
 
 /***************************
@@ -4,32 +4,63 @@
 // X11/Xlib.h uses C langauge calling. 
 extern "C" { 
 #include <X11/Xlib.h> 
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/sync.h>
 }
 // General utilities to manage dynamic memory
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <typeinfo>
 #include <cstring>
 #include <algorithm>
 #include <glog/logging.h>
 #include <iostream>
 
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+
 #include "util.hpp"
+#include "config.hpp"
+#include "drag_engine.hpp"
+#include "event_loop.hpp"
+#include "event_scheduler.hpp"
+#include "event_stats.hpp"
+#include "event_trace.hpp"
+#include "async_log_sink.hpp"
+#include "client_throttle.hpp"
+#include "span_tracer.hpp"
+#include "x_request_stats.hpp"
 #include "xlib_window.hpp"
+#include "xlib_client_registry.hpp"
+#include "xlib_mru_list.hpp"
+#include "xlib_window_index.hpp"
+#include "xlib_resources.hpp"
+#include "xlib_stacking_list.hpp"
 
 class WindowManager
 {
 public:
-	::std::unordered_map<Window, XLib_Window> frame_map_;
-	::std::unordered_map<Window, XLib_Window> button_map_;
+	// owns every managed client, window_index_ only holds handles into it
+	XLib_ClientRegistry clients_;
+	// every window of every client -> (client, role)
+	XLib_WindowIndex window_index_;
+	// handler latencies, also read by swim_replay
+	EventStats event_stats_;
 
 	/** Function: Create
 	 * - Establishes connection to X server.
 	 * - Creates a WindowManager instance. 
 	 **/
-	static ::std::unique_ptr<WindowManager> Create(const std::string& display_str = std::string());
+	static ::std::unique_ptr<WindowManager> Create(const std::string& display_str = std::string(),
+		const Config& config = Config());
 	/** Function: Destructor
 	 * - Disconnects from the X server.
 	 **/
@@ -39,14 +70,60 @@ public:
 	 **/
 	void run();
 
+	/** Function: dispatchEvent
+	 * - Times and hands a single event to its handler.
+	 **/
+	void dispatchEvent(XEvent& e);
+	/** Function: queueEvent
+	 * - traces an event as received and hands it to the scheduler.
+	 **/
+	void queueEvent(const XEvent& e);
+	/** Function: dispatchQueued
+	 * - dispatches what the scheduler picks for this batch, returns how
+	 *   many events that was. endBatch() should follow.
+	 **/
+	int dispatchQueued();
+	/** Function: endBatch
+	 * - applies what the handlers deferred to the end of the batch
+	 *   (merged ConfigureRequests, stacking changes), runs due timers,
+	 *   then flushes.
+	 **/
+	void endBatch();
+
+	/** Function: OnDumpStats [SIGNAL HANDLER]
+	 * - SIGUSR1 requests a dump of the event stats; the signal wakes run().
+	 **/
+	static void OnDumpStats(int signal);
+	/** Function: OnToggleSpans [SIGNAL HANDLER]
+	 * - SIGUSR2 starts/stops (and writes) a span trace, from run().
+	 **/
+	static void OnToggleSpans(int signal);
+
 private:
-	WindowManager(Display* display);
+	WindowManager(Display* display, const Config& config);
 	void Frame(Window w, bool created_before_window_manager);
-	void Unframe(Window w);
+	void Unframe(ClientHandle handle);
+
+	/** Function: manageWindow
+	 * - frames w and registers the new client in clients_ and window_index_.
+	 * - info, if given, is used instead of querying the server.
+	 **/
+	ClientHandle manageWindow(Window w, const XLib_ClientInfo* info = nullptr);
+	void adoptExistingWindows();
+	void prefillDecorationPool();
+	/** Function: findClient
+	 * - resolves any window of a client (one index probe), nullptr if
+	 *   w is not managed. role (optional) receives which window w is.
+	 **/
+	XLib_Window* findClient(Window w, WindowRole* role = nullptr, ClientHandle* handle = nullptr);
+	/** Function: hitTest
+	 * - role of the decoration under (x, y) of a pointer event on a
+	 *   window of window_ that has the given (indexed) role.
+	 **/
+	WindowRole hitTest(XLib_Window* window_, WindowRole role, int x, int y);
 
 	GC create_gc(Display* display_, Window w);
 
-	void redrawAllWindows();
 
 	void OnCreateNotify(const XCreateWindowEvent& e);
 	void OnDestroyNotify(const XDestroyWindowEvent& e);
@@ -56,19 +133,62 @@ private:
 	void OnUnmapNotify(const XUnmapEvent& e);
 
 	void OnConfigureNotify(const XConfigureEvent& e);
+	void OnExpose(const XExposeEvent& e);
 	
 	
 	void OnMapRequest(const XMapRequestEvent& e);
 	void OnConfigureRequest(const XConfigureRequestEvent& e);
+	/** Function: applyConfigure
+	 * - grants a (merged) ConfigureRequest for w.
+	 **/
+	void applyConfigure(Window w, unsigned long value_mask, XWindowChanges& changes);
+	void applyPendingConfigures(uint64_t now_ns, uint64_t& ready_ns);
+	void applyPendingConfigure(Window w);
+	/** Function: mapClient
+	 * - grants a MapRequest: frames w and maps it.
+	 **/
+	void mapClient(Window w);
+	void applyDeferredMaps(uint64_t now_ns, uint64_t& ready_ns);
+	/** Function: applyDeferred
+	 * - grants the pending configures and maps throttle_ admits now,
+	 *   and arms throttle_timer_ for the rest.
+	 **/
+	void applyDeferred(uint64_t now_ns);
 	
 
 	void OnButtonPress(const XButtonEvent& e);
 	void OnButtonRelease(const XButtonEvent& e);
 
 	void OnMotionNotify(const XMotionEvent& e);
+	void applyDrag();
+	void applyDragGeometry(XLib_Window* window_);
+	/** Function: armDragTimer
+	 * - arms drag_timer_ for pending drag motion, disarms it otherwise.
+	 **/
+	void armDragTimer();
+	void drawOutline(const XRectangle& area);
+	void eraseOutline();
+	void setupSync(XLib_Window* window_);
+	bool sendSyncRequest(XLib_Window* window_);
+	void OnSyncAlarmNotify(const XSyncAlarmNotifyEvent& e);
 
 	void OnKeyPress(const XKeyEvent& e);
 	void OnKeyRelease(const XKeyEvent& e); 
+	/** Function: focusClient
+	 * - raises and focuses handle, making it the most recent in mru_.
+	 **/
+	void focusClient(ClientHandle handle);
+	/** Function: cycleFocus
+	 * - Alt+Tab: starts a cycle (grabbing the keyboard) or moves it one
+	 *   client on in MRU order, previewing that client by raising it.
+	 **/
+	void cycleFocus(bool forward);
+	/** Function: endCycle
+	 * - commits (focuses) the previewed client, or goes back to where
+	 *   the cycle started.
+	 **/
+	void endCycle(bool commit);
+	bool altHeld();
 
 	static int OnXError(Display* display, XErrorEvent* e);
 	/** Function: OnWMDetected
@@ -84,17 +204,97 @@ private:
 	 * Variable is set by OnWMDetected and hence must be static **/
 	static bool wm_detected_;
 	static ::std::mutex wm_detected_mutex_;
+	/**
+	 * Set by OnDumpStats, cleared by run() once the stats are logged **/
+	static volatile ::std::sig_atomic_t dump_stats_requested_;
+	/**
+	 * Set by OnToggleSpans, cleared by run() once toggleSpanTrace() ran **/
+	static volatile ::std::sig_atomic_t span_toggle_requested_;
+	/**
+	 * Written by the signal handlers, read by loop_ (see run()) **/
+	static int signal_pipe_[2];
+	static void wakeEventLoop();
+	void toggleSpanTrace();
+	/** Function: dispatchBatch
+	 * - moves the events queued on the connection into scheduler_,
+	 *   dispatches what it schedules for this batch, then flushes once
+	 *   for all of them.
+	 **/
+	void dispatchBatch(int count);
+	void handleSignalRequests();
+
+	// requests, round-trips and bytes per handler
+	XRequestStats request_stats_;
+	// every event received, if config_.trace_path_ is set
+	EventTraceWriter trace_;
+	// every event as text, if config_.event_log_path_ is set
+	AsyncLogSink event_log_;
+
+	// stacking order of the clients, sent once per batch
+	XLib_StackingList stacking_;
+	// clients by focus, most recent first
+	XLib_MruList mru_;
+	/**
+	 * Alt+Tab cycle in progress: current_ is previewed while Alt is
+	 * held, and focused when it is released. stacking_ is the order
+	 * to go back to on Escape **/
+	struct
+	{
+		bool active_;
+		ClientHandle origin_;
+		ClientHandle current_;
+		::std::vector<XLib_StackingList::Entry> stacking_;
+	}cycle_;
+
+	// GCs shared by every frame
+	XLib_Resources resources_;
+
+	const Config config_;
 
 	Display* display_;
 	const Window root_;
 
-	Position<int> drag_start_pos_;
-	Position<int> drag_start_frame_pos_;
-	Size<int> drag_start_frame_size_;
+	/**
+	 * ConfigureRequests not granted yet, one per window: later requests
+	 * overwrite the fields they set. endBatch() grants them, unless
+	 * throttle_ holds the client back **/
+	struct PendingConfigure
+	{
+		Window window_;
+		unsigned long value_mask_;
+		XWindowChanges changes_;
+	};
+	::std::vector<PendingConfigure> pending_configures_;
+	// MapRequests throttle_ refused, in arrival order
+	::std::vector<Window> deferred_maps_;
+	// per client limits on configures and maps
+	ClientThrottle throttle_;
+	// grants deferred work once throttle_ admits it
+	EventLoop::TimerId throttle_timer_;
+
+	// input lane / client lane ordering of each batch
+	EventScheduler scheduler_;
+	// the poll() the main loop sleeps in, with its timers and extra fds
+	EventLoop loop_;
+	DragEngine drag_;
+	// applies paced drag motion that no later motion event picked up
+	EventLoop::TimerId drag_timer_;
+	/**
+	 * Outline currently XORed on the root window (outline drag mode) **/
+	struct
+	{
+		bool drawn_;
+		XRectangle area_;
+	}outline_;
 
 	// Atom constants 
-	const Atom WM_PROTOCOLS;
-	const Atom WM_DELETE_WINDOW;
+	Atom WM_PROTOCOLS;
+	Atom WM_DELETE_WINDOW;
+	Atom _NET_WM_SYNC_REQUEST;
+	Atom _NET_WM_SYNC_REQUEST_COUNTER;
+
+	bool sync_available_;
+	int sync_event_base_;
 };
 
 #endif
\ No newline at end of file
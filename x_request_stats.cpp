@@ -0,0 +1,107 @@
+#include "x_request_stats.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "util.hpp"
+
+// for the Display output buffer; last, it defines min/max macros
+extern "C" {
+#include <X11/Xlibint.h>
+}
+#undef min
+#undef max
+
+uint64_t XRequestStats::round_trips_ = 0;
+uint64_t XRequestStats::bytes_flushed_ = 0;
+
+XRequestStats::XRequestStats()
+{
+	memset(handlers_, 0, sizeof(handlers_));
+	memset(&startup_, 0, sizeof(startup_));
+	memset(&deferred_, 0, sizeof(deferred_));
+}
+
+void XRequestStats::attach(Display* display)
+{
+	// a private extension record, only to get the flush callback
+	XExtCodes* codes = XAddExtension(display);
+	XESetBeforeFlush(display, codes->extension, &XRequestStats::OnBeforeFlush);
+}
+
+void XRequestStats::OnBeforeFlush(Display* display, XExtCodes* codes, const char* data, long length)
+{
+	bytes_flushed_ += length;
+}
+
+/*-------------------------------------------------------------------
+ * Function: bytesWritten
+ * - bytes flushed so far plus the ones waiting in the output buffer.
+ *-------------------------------------------------------------------*/
+uint64_t XRequestStats::bytesWritten(Display* display) const
+{
+	return bytes_flushed_ + (display->bufptr - display->buffer);
+}
+
+XRequestStats::Mark XRequestStats::mark(Display* display) const
+{
+	return Mark{ NextRequest(display), round_trips_, bytesWritten(display) };
+}
+
+void XRequestStats::add(Counters& counters, const Mark& start, const Mark& end)
+{
+	const uint64_t requests = end.request_ - start.request_;
+	const uint64_t round_trips = end.round_trips_ - start.round_trips_;
+
+	++counters.calls_;
+	counters.requests_ += requests;
+	counters.round_trips_ += round_trips;
+	counters.bytes_ += end.bytes_ - start.bytes_;
+	if(requests > counters.max_requests_)
+		counters.max_requests_ = requests;
+	if(round_trips > counters.max_round_trips_)
+		counters.max_round_trips_ = round_trips;
+}
+
+void XRequestStats::record(int event_type, Display* display, const Mark& start)
+{
+	if(event_type < 0 || event_type >= LASTEvent)
+		return;
+	add(handlers_[event_type], start, mark(display));
+}
+
+void XRequestStats::recordStartup(Display* display, const Mark& start)
+{
+	add(startup_, start, mark(display));
+}
+
+void XRequestStats::recordDeferred(Display* display, const Mark& start)
+{
+	add(deferred_, start, mark(display));
+}
+
+::std::string XRequestStats::toString() const
+{
+	::std::ostringstream out;
+	out << ::std::fixed << ::std::setprecision(1);
+	out << "XRequestStats {startup: " << startup_.requests_ << " requests, "
+		<< startup_.round_trips_ << " round-trips, " << startup_.bytes_ << " bytes }\n";
+
+	for(int type = 0; type <= LASTEvent; ++type)
+	{
+		// deferred_ last, as if it were one more event type
+		const Counters& c = (type < LASTEvent) ? handlers_[type] : deferred_;
+		if(c.calls_ == 0)
+			continue;
+		out << "\t" << ::std::left << ::std::setw(18) 
+			<< ((type < LASTEvent) ? XEventTypeToString(type) : "(end of batch)") << ::std::right
+			<< " n=" << c.calls_
+			<< " requests=" << static_cast<double>(c.requests_) / c.calls_
+			<< " (max " << c.max_requests_ << ")"
+			<< " round-trips=" << static_cast<double>(c.round_trips_) / c.calls_
+			<< " (max " << c.max_round_trips_ << ")"
+			<< " bytes=" << static_cast<double>(c.bytes_) / c.calls_ << "\n";
+	}
+	return out.str();
+}
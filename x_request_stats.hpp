@@ -0,0 +1,80 @@
+#ifndef X_REQUEST_STATS_HPP
+#define X_REQUEST_STATS_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstdint>
+#include <string>
+
+/*-----------------------------------------------
+ * Class: XRequestStats
+ * - X protocol cost of each handler: requests issued, blocking
+ *   round-trips waited on and bytes written to the connection.
+ * - requests come from the connection's sequence numbers, so every
+ *   request is counted, wrapped or not. Round-trips are counted by
+ *   X_ROUND_TRIP around each blocking call. Bytes are counted as
+ *   Xlib flushes them (XESetBeforeFlush), plus what is still buffered.
+ *-----------------------------------------------*/
+class XRequestStats
+{
+public:
+	struct Counters
+	{
+		uint64_t calls_;
+		uint64_t requests_;
+		uint64_t round_trips_;
+		uint64_t bytes_;
+		uint64_t max_requests_;
+		uint64_t max_round_trips_;
+	};
+
+	// the connection state at the start of a handler
+	struct Mark
+	{
+		unsigned long request_;
+		uint64_t round_trips_;
+		uint64_t bytes_;
+	};
+
+	// every blocking call so far, process wide (see X_ROUND_TRIP)
+	static uint64_t round_trips_;
+
+	XRequestStats();
+
+	/** Function: attach
+	 * - hooks byte counting into display's flushes.
+	 **/
+	void attach(Display* display);
+
+	Mark mark(Display* display) const;
+	void record(int event_type, Display* display, const Mark& start);
+	void recordStartup(Display* display, const Mark& start);
+	/** Function: recordDeferred
+	 * - work handlers left for the end of their batch (endBatch()).
+	 **/
+	void recordDeferred(Display* display, const Mark& start);
+
+	::std::string toString() const;
+
+private:
+	uint64_t bytesWritten(Display* display) const;
+	static void add(Counters& counters, const Mark& start, const Mark& end);
+	static void OnBeforeFlush(Display* display, XExtCodes* codes, const char* data, long length);
+
+	static uint64_t bytes_flushed_;
+
+	Counters handlers_[LASTEvent];
+	Counters startup_;
+	Counters deferred_;
+};
+
+/*-----------------------------------------------
+ * Macro: X_ROUND_TRIP
+ * - wraps an Xlib call that waits on a reply, e.g.
+ *   CHECK(X_ROUND_TRIP(XGetWindowAttributes(display_, w, &attrs)));
+ *-----------------------------------------------*/
+#define X_ROUND_TRIP(call) (++XRequestStats::round_trips_, (call))
+
+#endif
@@ -1,11 +1,10 @@
 #include "xlib_border.hpp"
 
-void XLib_Border::createWindow(Display* display_, Window root_)
+void XLib_Border::createWindow(Display* display_, Window root_, XLib_Resources& resources_)
 {
-	XVisualInfo vinfo;
-	XMatchVisualInfo(display_, DefaultScreen(display_), 32, TrueColor, &vinfo);
+	const XVisualInfo& vinfo = resources_.colour_cache_.argbVisual(display_, root_);
 	XSetWindowAttributes attr;
-	attr.colormap = XCreateColormap(display_, root_, vinfo.visual, AllocNone);
+	attr.colormap = resources_.colour_cache_.argbColormap(display_, root_);
 	attr.border_pixel = border_properties_.border_colour_;
 	attr.background_pixel = border_properties_.background_colour_;
 
@@ -15,39 +14,60 @@ void XLib_Border::createWindow(Display* display_, Window root_)
 		border_properties_.border_size_.width, 
 		border_properties_.border_size_.height + border_height, 0, 
 		vinfo.depth, InputOutput, vinfo.visual, CWColormap | CWBorderPixel | CWBackPixel, &attr);
+	depth_ = vinfo.depth;
 
 }
-void XLib_Border::createRectangles(Display* display_, Window root_)
+void XLib_Border::createRectangles(Display* display_, Window root_, XLib_Resources& resources_)
 {
-	createGC(display_, root_);
+	GC gc = resources_.gc_cache_.get(display_, root_, depth_, 0x3443ea, 0x3443ea);
 	XFillRectangle(display_, border_window_, gc, 0, 0, 
 		border_properties_.border_size_.width * 2 / 3, border_height);
-	drawTitle(display_);
+	drawTitle(display_, root_, resources_);
 }
-void XLib_Border::drawTitle(Display* display_)
+void XLib_Border::drawTitle(Display* display_, Window root_, XLib_Resources& resources_)
 {
-	XSetForeground(display_, gc, 0x000000);
-	XFontStruct* myFont = XLoadQueryFont(display_, 
-		"-adobe-helvetica-bold-r-normal--0-0-0-0-p-0-iso8859-15"); // FONT CURRENTLY NOT
-	XSetFont(display_, gc, myFont->fid);
-	std::string title = border_properties_.window_name_;
-	XDrawString(display_, border_window_, gc, border_height/2, 12, title.c_str(), title.length());
+	XFontStruct* font = resources_.font_cache_.get(display_, 
+		"-adobe-helvetica-bold-r-normal--0-0-0-0-p-0-iso8859-15");
+	if(font == nullptr)
+		return;
+
+	const unsigned int bar_width = border_properties_.border_size_.width * 2 / 3;
+	const unsigned int text_x = border_height/2;
+	layoutTitle(font, bar_width > text_x * 2 ? bar_width - text_x * 2 : 0);
+
+	GC gc = resources_.gc_cache_.get(display_, root_, depth_, 0x000000, 0x3443ea, LineSolid, font->fid);
+	const ::std::string& title = title_layout_.text_;
+	XDrawString(display_, border_window_, gc, text_x, 12, title.c_str(), title.length());
 }
-// how to create graphics context?? what window is needed aside from border_window_???
-void XLib_Border::createGC(Display* display_, Window root_)
+/*-------------------------------------------------------------------
+ * Function: layoutTitle
+ * - fits window_name_ into max_width pixels, ending in "..." if it
+ *   had to be cut. XTextWidth is client side, so this costs no requests.
+ *-------------------------------------------------------------------*/
+void XLib_Border::layoutTitle(XFontStruct* font, unsigned int max_width)
 {
-	unsigned long valuemask = 0;
-	XGCValues values;	// initial values for the GC
-	unsigned int line_width = 1; // line width of the GC
-	int line_style = LineSolid;
-	int cap_style = CapButt;
-	int join_style = JoinBevel;
-	int screen_num = DefaultScreen(display_);
-
-	gc = XCreateGC(display_, border_window_, valuemask, &values);
-
-	XSetForeground(display_, gc, 0x3443ea);
-	XSetBackground(display_, gc, 0x3443ea);
-	XSetLineAttributes(display_, gc, line_width, line_style, cap_style, join_style);
-	XSetFillStyle(display_, gc, FillSolid);
-}
\ No newline at end of file
+	const ::std::string& name = border_properties_.window_name_;
+	if(title_layout_.valid_ && 
+		title_layout_.max_width_ == max_width && 
+		title_layout_.source_ == name)
+		return;
+
+	title_layout_.valid_ = true;
+	title_layout_.source_ = name;
+	title_layout_.max_width_ = max_width;
+
+	if(XTextWidth(font, name.c_str(), name.length()) <= static_cast<int>(max_width))
+	{
+		title_layout_.text_ = name;
+		return;
+	}
+
+	static const char* const ELLIPSIS = "...";
+	const int ellipsis_width = XTextWidth(font, ELLIPSIS, 3);
+	::std::string::size_type length = name.length();
+	while(length > 0 && 
+		XTextWidth(font, name.c_str(), length) + ellipsis_width > static_cast<int>(max_width))
+		--length;
+
+	title_layout_.text_ = name.substr(0, length) + ELLIPSIS;
+}
@@ -15,12 +15,12 @@ extern "C" {
 #include <iostream>
 #include <cstdlib>
 #include "util.hpp"
+#include "xlib_resources.hpp"
 
 
 class XLib_Border
 {
 public:
-	GC gc;
 	::std::string window_title_;
 
 	Window border_window_;
@@ -41,12 +41,24 @@ public:
 
 	}border_properties_;
 
-	void createWindow(Display* display_, Window root_);
-	void createRectangles(Display* display_, Window root_);
-	void drawTitle(Display* display_);
-	void createGC(Display* display_, Window root_);
+	/**
+	 * Title as last laid out, only recomputed by layoutTitle() when the
+	 * window name or the border width changes. **/
+	struct
+	{
+		bool valid_ = false;
+		::std::string source_; 	// window_name_ it was computed from
+		unsigned int max_width_;	// space available for the text
+		::std::string text_;		// source_, ellipsized to fit max_width_
+	}title_layout_;
+
+	void createWindow(Display* display_, Window root_, XLib_Resources& resources_);
+	void createRectangles(Display* display_, Window root_, XLib_Resources& resources_);
+	void drawTitle(Display* display_, Window root_, XLib_Resources& resources_);
+	void layoutTitle(XFontStruct* font, unsigned int max_width);
 
 	unsigned int border_height = 20;
+	int depth_; // depth of the matched 32 bit visual
 };
 
 #endif
\ No newline at end of file
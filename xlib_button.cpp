@@ -15,30 +15,27 @@ void XLib_Button::createWindow(Display* display_, Window root_)
 		);
 }
 
-void XLib_Button::createRectangles(Display* display_, Window root_)
+void XLib_Button::createRectangles(Display* display_, Window root_, XLib_Resources& resources_)
 {
-	createGC(display_, root_);
+	GC gc = resources_.gc_cache_.get(display_, root_, depth_,
+		button_properties_.button_colour_, button_properties_.button_colour_);
 	XFillRectangle(display_, button_window_, gc, 0, 0, 
 		button_properties_.button_size_.width, button_properties_.button_size_.height);
 }
 
-void XLib_Button::createGC(Display* display_, Window root_)
+void XLib_Button::paintOn(Display* display_, Window root_, Window parent, XLib_Resources& resources_)
 {
-	unsigned long valuemask = 0;
-
-	XGCValues values;	// initial values for the GC
-	unsigned int line_width = 1; // line width of the GC
-	int line_style = LineSolid;
-	int cap_style = CapButt;
-	int join_style = JoinBevel;
-	int screen_num = DefaultScreen(display_);
-
-	gc = XCreateGC(display_, button_window_, valuemask, &values);
-
-	XSetForeground(display_, gc, button_properties_.button_colour_);
-	XSetBackground(display_, gc, button_properties_.button_colour_);
-
-	XSetLineAttributes(display_, gc, line_width, line_style, cap_style, join_style);
+	GC gc = resources_.gc_cache_.get(display_, root_, depth_,
+		button_properties_.button_colour_, button_properties_.button_colour_);
+	XFillRectangle(display_, parent, gc, 
+		button_properties_.button_position_.x, button_properties_.button_position_.y,
+		button_properties_.button_size_.width, button_properties_.button_size_.height);
+}
 
-	XSetFillStyle(display_, gc, FillSolid);
-}
\ No newline at end of file
+bool XLib_Button::contains(int x, int y) const
+{
+	return x >= button_properties_.button_position_.x &&
+		y >= button_properties_.button_position_.y &&
+		x < button_properties_.button_position_.x + button_properties_.button_size_.width &&
+		y < button_properties_.button_position_.y + button_properties_.button_size_.height;
+}
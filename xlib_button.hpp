@@ -14,13 +14,12 @@ extern "C" {
 #include <iostream>
 #include <cstdlib>
 #include "util.hpp"
+#include "xlib_resources.hpp"
 
 
 class XLib_Button
 {
 public:
-	GC gc;
-	
 	Window button_window_;
 	//Window application_window_;
 
@@ -32,9 +31,19 @@ public:
 
 	}button_properties_;
 
+	int depth_; // copied from the parent (border) window
+
 	void createWindow(Display* display_, Window root_);
-	void createRectangles(Display* display_, Window root_);
-	void createGC(Display* display_, Window root_);
+	void createRectangles(Display* display_, Window root_, XLib_Resources& resources_);
+	/** Function: paintOn
+	 * - draws the button as a region of parent (at button_position_),
+	 *   for decorations without a button window.
+	 **/
+	void paintOn(Display* display_, Window root_, Window parent, XLib_Resources& resources_);
+	/** Function: contains
+	 * - hit test, x and y relative to the parent window.
+	 **/
+	bool contains(int x, int y) const;
 };
 
 #endif
\ No newline at end of file
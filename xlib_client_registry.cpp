@@ -0,0 +1,77 @@
+#include "xlib_client_registry.hpp"
+
+/*-------------------------------------------------------------------
+ * Function: create
+ * - reuses a free slot if there is one, so the slab only grows to the
+ *   peak number of clients.
+ *-------------------------------------------------------------------*/
+ClientHandle XLib_ClientRegistry::create()
+{
+	uint32_t index;
+	if(!free_slots_.empty())
+	{
+		index = free_slots_.back();
+		free_slots_.pop_back();
+		slots_[index].window_ = XLib_Window();
+	}
+	else
+	{
+		index = slots_.size();
+		slots_.emplace_back();
+		slots_[index].generation_ = 0;
+	}
+
+	Slot& slot = slots_[index];
+	slot.alive_ = true;
+
+	::std::ostringstream id;
+	id << "XLib_Window[" << index << "." << slot.generation_ << "]";
+	slot.window_.xlib_window_id = id.str();
+
+	return ClientHandle{ index, slot.generation_ };
+}
+
+/*-------------------------------------------------------------------
+ * Function: destroy
+ *-------------------------------------------------------------------*/
+void XLib_ClientRegistry::destroy(ClientHandle handle)
+{
+	if(get(handle) == nullptr)
+		return;
+
+	Slot& slot = slots_[handle.index_];
+	slot.alive_ = false;
+	++slot.generation_;
+	free_slots_.push_back(handle.index_);
+}
+
+/*-------------------------------------------------------------------
+ * Function: get
+ *-------------------------------------------------------------------*/
+XLib_Window* XLib_ClientRegistry::get(ClientHandle handle)
+{
+	if(handle.index_ >= slots_.size())
+		return nullptr;
+
+	Slot& slot = slots_[handle.index_];
+	if(!slot.alive_ || slot.generation_ != handle.generation_)
+		return nullptr;
+	return &slot.window_;
+}
+
+ClientHandle XLib_ClientRegistry::next(ClientHandle handle) const
+{
+	const uint32_t count = slots_.size();
+	for(uint32_t i = 1; i <= count; ++i)
+	{
+		const uint32_t index = (handle.index_ + i) % count;
+		if(slots_[index].alive_)
+			return ClientHandle{ index, slots_[index].generation_ };
+	}
+	return handle;
+}
+
+::std::size_t XLib_ClientRegistry::size() const
+{
+	return slots_.size() - free_slots_.size();
+}
@@ -0,0 +1,68 @@
+#ifndef XLIB_CLIENT_REGISTRY_HPP
+#define XLIB_CLIENT_REGISTRY_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "client_handle.hpp"
+#include "xlib_window.hpp"
+
+/*-----------------------------------------------
+ * Class: XLib_ClientRegistry
+ * - owns every managed XLib_Window exactly once, in a contiguous slab.
+ * - every lookup table maps X window ids to a ClientHandle, never to a
+ *   copy of the client.
+ * - pointers returned by get() are only valid until the next create(),
+ *   (the slab may grow), handles stay valid until destroy().
+ *-----------------------------------------------*/
+class XLib_ClientRegistry
+{
+public:
+	ClientHandle create();
+	void destroy(ClientHandle handle);
+
+	/** Function: get
+	 * - returns the client, or nullptr for a stale handle.
+	 **/
+	XLib_Window* get(ClientHandle handle);
+
+	::std::size_t size() const;
+
+	/** Function: next
+	 * - the next live client after handle in slab order, wrapping
+	 *   around (handle itself if it is the only client).
+	 **/
+	ClientHandle next(ClientHandle handle) const;
+
+	/** Function: forEach
+	 * - calls f(handle, client) for every live client.
+	 **/
+	template <typename F>
+	void forEach(F f);
+
+private:
+	struct Slot
+	{
+		XLib_Window window_;
+		uint32_t generation_;
+		bool alive_;
+	};
+
+	::std::vector<Slot> slots_;
+	::std::vector<uint32_t> free_slots_;
+};
+
+/*----------------------------------------------------------------------------
+ * IMPLEMENTATION STAGE
+ *----------------------------------------------------------------------------*/
+template <typename F>
+void XLib_ClientRegistry::forEach(F f)
+{
+	for(uint32_t i = 0; i < slots_.size(); ++i)
+	{
+		if(slots_[i].alive_)
+			f(ClientHandle{ i, slots_[i].generation_ }, slots_[i].window_);
+	}
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "xlib_mru_list.hpp"
+
+void XLib_MruList::unlink(XLib_ClientRegistry& clients_, XLib_Window* window_)
+{
+	if(window_->mru_.prev_ != NO_CLIENT)
+		clients_.get(window_->mru_.prev_)->mru_.next_ = window_->mru_.next_;
+	else
+		head_ = window_->mru_.next_;
+
+	if(window_->mru_.next_ != NO_CLIENT)
+		clients_.get(window_->mru_.next_)->mru_.prev_ = window_->mru_.prev_;
+	else
+		tail_ = window_->mru_.prev_;
+
+	window_->mru_.linked_ = false;
+	window_->mru_.prev_ = NO_CLIENT;
+	window_->mru_.next_ = NO_CLIENT;
+	--size_;
+}
+
+void XLib_MruList::touch(XLib_ClientRegistry& clients_, ClientHandle handle)
+{
+	XLib_Window* window_ = clients_.get(handle);
+	if(window_ == nullptr || handle == head_)
+		return;
+	if(window_->mru_.linked_)
+		unlink(clients_, window_);
+
+	window_->mru_.linked_ = true;
+	window_->mru_.prev_ = NO_CLIENT;
+	window_->mru_.next_ = head_;
+	if(head_ != NO_CLIENT)
+		clients_.get(head_)->mru_.prev_ = handle;
+	else
+		tail_ = handle;
+	head_ = handle;
+	++size_;
+}
+
+void XLib_MruList::append(XLib_ClientRegistry& clients_, ClientHandle handle)
+{
+	XLib_Window* window_ = clients_.get(handle);
+	if(window_ == nullptr || window_->mru_.linked_)
+		return;
+
+	window_->mru_.linked_ = true;
+	window_->mru_.prev_ = tail_;
+	window_->mru_.next_ = NO_CLIENT;
+	if(tail_ != NO_CLIENT)
+		clients_.get(tail_)->mru_.next_ = handle;
+	else
+		head_ = handle;
+	tail_ = handle;
+	++size_;
+}
+
+/*-------------------------------------------------------------------
+ * Function: remove
+ * - must run before the client is destroyed in the registry.
+ *-------------------------------------------------------------------*/
+void XLib_MruList::remove(XLib_ClientRegistry& clients_, ClientHandle handle)
+{
+	XLib_Window* window_ = clients_.get(handle);
+	if(window_ && window_->mru_.linked_)
+		unlink(clients_, window_);
+}
+
+ClientHandle XLib_MruList::next(XLib_ClientRegistry& clients_, ClientHandle handle) const
+{
+	const XLib_Window* window_ = clients_.get(handle);
+	if(window_ == nullptr || !window_->mru_.linked_)
+		return NO_CLIENT;
+	return (window_->mru_.next_ != NO_CLIENT) ? window_->mru_.next_ : head_;
+}
+
+ClientHandle XLib_MruList::prev(XLib_ClientRegistry& clients_, ClientHandle handle) const
+{
+	const XLib_Window* window_ = clients_.get(handle);
+	if(window_ == nullptr || !window_->mru_.linked_)
+		return NO_CLIENT;
+	return (window_->mru_.prev_ != NO_CLIENT) ? window_->mru_.prev_ : tail_;
+}
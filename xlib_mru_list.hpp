@@ -0,0 +1,51 @@
+#ifndef XLIB_MRU_LIST_HPP
+#define XLIB_MRU_LIST_HPP
+
+#include <cstddef>
+
+#include "xlib_client_registry.hpp"
+
+/*-----------------------------------------------
+ * Class: XLib_MruList
+ * - clients from the most to the least recently focused, as a doubly
+ *   linked list threaded through the clients themselves
+ *   (XLib_Window::mru_), so every operation is O(1) whatever the number
+ *   of clients.
+ * - links are handles, not pointers: the registry's slab may move.
+ *-----------------------------------------------*/
+class XLib_MruList
+{
+public:
+	/** Function: touch
+	 * - makes handle the most recent (adds it if it is not listed).
+	 **/
+	void touch(XLib_ClientRegistry& clients_, ClientHandle handle);
+	/** Function: append
+	 * - lists handle as the least recent (a new client, not focused
+	 *   yet); does nothing if it is listed already.
+	 **/
+	void append(XLib_ClientRegistry& clients_, ClientHandle handle);
+	void remove(XLib_ClientRegistry& clients_, ClientHandle handle);
+
+	/** Function: front
+	 * - the most recently focused client, NO_CLIENT if empty.
+	 **/
+	ClientHandle front() const { return head_; }
+	::std::size_t size() const { return size_; }
+
+	/** Function: next / prev
+	 * - the less / more recent client after handle, wrapping around
+	 *   (handle itself if it is the only one, NO_CLIENT if not listed).
+	 **/
+	ClientHandle next(XLib_ClientRegistry& clients_, ClientHandle handle) const;
+	ClientHandle prev(XLib_ClientRegistry& clients_, ClientHandle handle) const;
+
+private:
+	void unlink(XLib_ClientRegistry& clients_, XLib_Window* window_);
+
+	ClientHandle head_ = NO_CLIENT;
+	ClientHandle tail_ = NO_CLIENT;
+	::std::size_t size_ = 0;
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "xlib_resources.hpp"
+#include <sstream>
+#include <vector>
+
+/*-------------------------------------------------------------------
+ * XLib_GCCache
+ *-------------------------------------------------------------------*/
+bool XLib_GCCache::Key::operator == (const Key& other) const
+{
+	return depth_ == other.depth_ &&
+		foreground_ == other.foreground_ &&
+		background_ == other.background_ &&
+		line_style_ == other.line_style_ &&
+		font_ == other.font_;
+}
+
+::std::size_t XLib_GCCache::KeyHash::operator () (const Key& key) const
+{
+	::std::size_t hash = key.foreground_;
+	hash = hash * 31 + key.background_;
+	hash = hash * 31 + key.depth_;
+	hash = hash * 31 + key.line_style_;
+	hash = hash * 31 + key.font_;
+	return hash;
+}
+
+GC XLib_GCCache::get(Display* display_, Window root_, int depth, unsigned long foreground,
+	unsigned long background, int line_style, Font font)
+{
+	const Key key = { depth, foreground, background, line_style, font };
+	auto it = gc_map_.find(key);
+	if(it != gc_map_.end())
+		return it->second;
+
+	auto pixmap = depth_pixmap_map_.find(depth);
+	if(pixmap == depth_pixmap_map_.end())
+		pixmap = depth_pixmap_map_.emplace(depth, XCreatePixmap(display_, root_, 1, 1, depth)).first;
+
+	// every attribute goes into the one CreateGC request
+	XGCValues values;
+	values.foreground = foreground;
+	values.background = background;
+	values.line_width = 1;
+	values.line_style = line_style;
+	values.cap_style = CapButt;
+	values.join_style = JoinBevel;
+	values.fill_style = FillSolid;
+	values.font = font;
+
+	GC gc = XCreateGC(display_, pixmap->second,
+		GCForeground | GCBackground | GCLineWidth | GCLineStyle |
+		GCCapStyle | GCJoinStyle | GCFillStyle | (font != None ? GCFont : 0),
+		&values);
+
+	gc_map_.emplace(key, gc);
+	return gc;
+}
+
+GC XLib_GCCache::outline(Display* display_, Window root_)
+{
+	if(outline_gc_)
+		return outline_gc_;
+
+	const int screen = DefaultScreen(display_);
+	XGCValues values;
+	values.function = GXxor;
+	values.foreground = WhitePixel(display_, screen) ^ BlackPixel(display_, screen);
+	values.line_width = 2;
+	values.subwindow_mode = IncludeInferiors;
+	outline_gc_ = XCreateGC(display_, root_, 
+		GCFunction | GCForeground | GCLineWidth | GCSubwindowMode, &values);
+	return outline_gc_;
+}
+
+void XLib_GCCache::free(Display* display_)
+{
+	if(outline_gc_)
+		XFreeGC(display_, outline_gc_);
+	outline_gc_ = nullptr;
+	for(auto& it: gc_map_)
+		XFreeGC(display_, it.second);
+	for(auto& it: depth_pixmap_map_)
+		XFreePixmap(display_, it.second);
+
+	gc_map_.clear();
+	depth_pixmap_map_.clear();
+}
+
+/*-------------------------------------------------------------------
+ * XLib_FontCache
+ *-------------------------------------------------------------------*/
+XFontStruct* XLib_FontCache::get(Display* display_, const ::std::string& name)
+{
+	auto it = font_map_.find(name);
+	if(it != font_map_.end())
+		return it->second;
+
+	XFontStruct* font = X_ROUND_TRIP(XLoadQueryFont(display_, name.c_str()));
+	if(font == nullptr && name != "fixed")
+		font = get(display_, "fixed");
+	else if(font == nullptr)
+		return nullptr;
+
+	font_map_.emplace(name, font);
+	return font;
+}
+
+void XLib_FontCache::free(Display* display_)
+{
+	// fallback entries share the "fixed" XFontStruct, free it only once
+	auto fixed = font_map_.find("fixed");
+	XFontStruct* fixed_font = (fixed != font_map_.end()) ? fixed->second : nullptr;
+
+	for(auto& it: font_map_)
+		if(it.second != fixed_font)
+			XFreeFont(display_, it.second);
+	if(fixed_font)
+		XFreeFont(display_, fixed_font);
+
+	font_map_.clear();
+}
+
+/*-------------------------------------------------------------------
+ * XLib_ColourCache
+ *-------------------------------------------------------------------*/
+void XLib_ColourCache::resolveArgb(Display* display_, Window root_)
+{
+	argb_resolved_ = true;
+	const int screen = DefaultScreen(display_);
+	if(XMatchVisualInfo(display_, screen, 32, TrueColor, &argb_visual_))
+	{
+		argb_colormap_ = XCreateColormap(display_, root_, argb_visual_.visual, AllocNone);
+		owns_argb_colormap_ = true;
+		return;
+	}
+
+	// no ARGB visual (e.g. no compositing support), use the default one
+	argb_visual_.visual = DefaultVisual(display_, screen);
+	argb_visual_.visualid = XVisualIDFromVisual(argb_visual_.visual);
+	argb_visual_.depth = DefaultDepth(display_, screen);
+	argb_colormap_ = DefaultColormap(display_, screen);
+	owns_argb_colormap_ = false;
+}
+
+const XVisualInfo& XLib_ColourCache::argbVisual(Display* display_, Window root_)
+{
+	if(!argb_resolved_)
+		resolveArgb(display_, root_);
+	return argb_visual_;
+}
+
+Colormap XLib_ColourCache::argbColormap(Display* display_, Window root_)
+{
+	if(!argb_resolved_)
+		resolveArgb(display_, root_);
+	return argb_colormap_;
+}
+
+/*-------------------------------------------------------------------
+ * Function: pixel
+ * - red, green, blue are 16 bit channels as in XColor.
+ *-------------------------------------------------------------------*/
+unsigned long XLib_ColourCache::pixel(Display* display_, unsigned short red, 
+	unsigned short green, unsigned short blue)
+{
+	const uint64_t key = (static_cast<uint64_t>(red) << 32) | 
+		(static_cast<uint64_t>(green) << 16) | blue;
+	auto it = pixel_map_.find(key);
+	if(it != pixel_map_.end())
+		return it->second;
+
+	const int screen = DefaultScreen(display_);
+	Visual* visual = DefaultVisual(display_, screen);
+	unsigned long value;
+
+	if(visual->c_class == TrueColor)
+	{
+		// scale each 16 bit channel into its mask
+		auto channel = [] (unsigned short c, unsigned long mask) {
+			if(mask == 0)
+				return 0ul;
+			int shift = 0;
+			while(!((mask >> shift) & 1))
+				++shift;
+			const unsigned long max = mask >> shift;
+			return ((static_cast<unsigned long>(c) * max / 0xffff) << shift) & mask;
+		};
+		value = channel(red, visual->red_mask) | 
+			channel(green, visual->green_mask) | 
+			channel(blue, visual->blue_mask);
+	}
+	else
+	{
+		XColor colour;
+		colour.red = red;
+		colour.green = green;
+		colour.blue = blue;
+		colour.flags = DoRed | DoGreen | DoBlue;
+		X_ROUND_TRIP(XAllocColor(display_, DefaultColormap(display_, screen), &colour));
+		value = colour.pixel;
+		allocated_pixels_ = true;
+	}
+
+	pixel_map_.emplace(key, value);
+	return value;
+}
+
+void XLib_ColourCache::free(Display* display_)
+{
+	if(allocated_pixels_)
+	{
+		::std::vector<unsigned long> pixels;
+		for(auto& it: pixel_map_)
+			pixels.push_back(it.second);
+		XFreeColors(display_, DefaultColormap(display_, DefaultScreen(display_)),
+			pixels.data(), pixels.size(), 0);
+	}
+	if(owns_argb_colormap_)
+		XFreeColormap(display_, argb_colormap_);
+
+	pixel_map_.clear();
+	allocated_pixels_ = false;
+	argb_resolved_ = false;
+	owns_argb_colormap_ = false;
+}
+
+/*-------------------------------------------------------------------
+ * XLib_DecorationPool
+ *-------------------------------------------------------------------*/
+bool XLib_DecorationPool::take(XLib_DecorationSet& set)
+{
+	if(sets_.empty())
+	{
+		++misses_;
+		return false;
+	}
+
+	set = sets_.back();
+	sets_.pop_back();
+	++hits_;
+	return true;
+}
+
+bool XLib_DecorationPool::give(const XLib_DecorationSet& set)
+{
+	if(sets_.size() >= high_water_mark_)
+	{
+		++discarded_;
+		return false;
+	}
+
+	sets_.push_back(set);
+	++returned_;
+	return true;
+}
+
+::std::string XLib_DecorationPool::toString() const
+{
+	::std::ostringstream out;
+	out << "DecorationPool {size: " << sets_.size() << "/" << high_water_mark_
+		<< ", hits: " << hits_
+		<< ", misses: " << misses_
+		<< ", returned: " << returned_
+		<< ", discarded: " << discarded_ << " }";
+	return out.str();
+}
+
+void XLib_DecorationPool::free(Display* display_)
+{
+	// frame_ and the buttons go with their border
+	for(auto& set: sets_)
+		XDestroyWindow(display_, set.border_window_);
+	sets_.clear();
+}
+
+/*-------------------------------------------------------------------
+ * XLib_Resources
+ *-------------------------------------------------------------------*/
+void XLib_Resources::free(Display* display_)
+{
+	decoration_pool_.free(display_);
+	gc_cache_.free(display_);
+	font_cache_.free(display_);
+	colour_cache_.free(display_);
+}
@@ -0,0 +1,175 @@
+#ifndef XLIB_RESOURCES_HPP
+#define XLIB_RESOURCES_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "x_request_stats.hpp"
+
+/*-----------------------------------------------
+ * Class: XLib_GCCache
+ * - graphics contexts shared by every border and button.
+ * - a GC is created once per (depth, foreground, background, line style,
+ *   font) and reused by every draw afterwards; callers must not change it.
+ *-----------------------------------------------*/
+class XLib_GCCache
+{
+public:
+	struct Key
+	{
+		int depth_;
+		unsigned long foreground_;
+		unsigned long background_;
+		int line_style_;
+		Font font_;
+
+		bool operator == (const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		::std::size_t operator () (const Key& key) const;
+	};
+
+	/** Function: get
+	 * - returns the cached GC for the key, creating it on a miss.
+	 **/
+	GC get(Display* display_, Window root_, int depth, unsigned long foreground,
+		unsigned long background, int line_style = LineSolid, Font font = None);
+	/** Function: outline
+	 * - XOR GC for rubber band outlines drawn on the root window over
+	 *   its children; drawing the same outline twice erases it.
+	 **/
+	GC outline(Display* display_, Window root_);
+	/** Function: free
+	 * - frees every GC (and the pixmaps they were created against).
+	 **/
+	void free(Display* display_);
+
+private:
+	::std::unordered_map<Key, GC, KeyHash> gc_map_;
+	GC outline_gc_ = nullptr;
+	// GCs can only be used on drawables of the depth they were created
+	// for, so each depth gets a 1x1 pixmap to create its GCs against.
+	::std::unordered_map<int, Pixmap> depth_pixmap_map_;
+};
+
+/*-----------------------------------------------
+ * Class: XLib_FontCache
+ * - decoration fonts, loaded once by name.
+ * - a font that fails to load falls back to "fixed" (and the fallback
+ *   is remembered, so a missing font costs one round-trip in total).
+ *-----------------------------------------------*/
+class XLib_FontCache
+{
+public:
+	XFontStruct* get(Display* display_, const ::std::string& name);
+	void free(Display* display_);
+
+private:
+	::std::unordered_map<::std::string, XFontStruct*> font_map_;
+};
+
+/*-----------------------------------------------
+ * Class: XLib_ColourCache
+ * - the 32 bit ARGB visual and its colormap, resolved once and shared
+ *   by every border (falls back to the default visual without one).
+ * - pixel values by RGB in the default colormap. On a TrueColor default
+ *   visual they are computed from the channel masks (no request at all),
+ *   otherwise each colour is allocated once.
+ *-----------------------------------------------*/
+class XLib_ColourCache
+{
+public:
+	const XVisualInfo& argbVisual(Display* display_, Window root_);
+	Colormap argbColormap(Display* display_, Window root_);
+
+	unsigned long pixel(Display* display_, unsigned short red, 
+		unsigned short green, unsigned short blue);
+
+	void free(Display* display_);
+
+private:
+	void resolveArgb(Display* display_, Window root_);
+
+	bool argb_resolved_ = false;
+	XVisualInfo argb_visual_;
+	Colormap argb_colormap_ = None;
+	bool owns_argb_colormap_ = false;
+
+	::std::unordered_map<uint64_t, unsigned long> pixel_map_;
+	bool allocated_pixels_ = false;
+};
+
+/*-----------------------------------------------
+ * Struct: XLib_DecorationSet
+ * - the server windows decorating one client. frame_ and the buttons
+ *   are children of border_window_.
+ *-----------------------------------------------*/
+struct XLib_DecorationSet
+{
+	Window frame_;
+	Window border_window_;
+	Window move_button_;
+	Window resize_button_;
+	Window close_button_;
+};
+
+/*-----------------------------------------------
+ * Class: XLib_DecorationPool
+ * - unmapped, already grabbed decoration sets, recycled between
+ *   short lived clients instead of being destroyed and recreated.
+ * - holds at most high_water_mark_ sets, give() refuses beyond that
+ *   and the caller destroys the set.
+ *-----------------------------------------------*/
+class XLib_DecorationPool
+{
+public:
+	unsigned int high_water_mark_ = 8;
+
+	uint64_t hits_ = 0;
+	uint64_t misses_ = 0;
+	uint64_t returned_ = 0;
+	uint64_t discarded_ = 0;
+
+	/** Function: take
+	 * - pops a set into set, false (a miss) if the pool is empty.
+	 **/
+	bool take(XLib_DecorationSet& set);
+	/** Function: give
+	 * - returns an unmapped set to the pool, false if the pool is full.
+	 **/
+	bool give(const XLib_DecorationSet& set);
+
+	::std::size_t size() const { return sets_.size(); }
+	::std::string toString() const;
+	void free(Display* display_);
+
+private:
+	::std::vector<XLib_DecorationSet> sets_;
+};
+
+/*-----------------------------------------------
+ * Struct: XLib_Resources
+ * - per screen server resources owned by the WindowManager and shared
+ *   by every XLib_Window it frames.
+ *-----------------------------------------------*/
+struct XLib_Resources
+{
+	XLib_GCCache gc_cache_;
+	XLib_FontCache font_cache_;
+	XLib_ColourCache colour_cache_;
+	XLib_DecorationPool decoration_pool_;
+
+	void free(Display* display_);
+};
+
+#endif
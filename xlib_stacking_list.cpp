@@ -0,0 +1,190 @@
+#include "xlib_stacking_list.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+XLib_StackingList::XLib_StackingList()
+	: dirty_(false),
+	  restacks_(0),
+	  changes_(0),
+	  redundant_(0)
+{
+
+}
+
+::std::size_t XLib_StackingList::find(ClientHandle handle) const
+{
+	for(::std::size_t i = 0; i < entries_.size(); ++i)
+		if(entries_[i].handle_ == handle)
+			return i;
+	return entries_.size();
+}
+
+::std::size_t XLib_StackingList::layerEnd(StackLayer layer) const
+{
+	::std::size_t end = 0;
+	while(end < entries_.size() && entries_[end].layer_ <= layer)
+		++end;
+	return end;
+}
+
+/*-------------------------------------------------------------------
+ * Function: move
+ * - shifts the entries in between by one, keeping their order.
+ *-------------------------------------------------------------------*/
+void XLib_StackingList::move(::std::size_t from, ::std::size_t to)
+{
+	if(from == to)
+	{
+		++redundant_;
+		return;
+	}
+
+	const Entry entry = entries_[from];
+	if(from < to)
+		for(::std::size_t i = from; i < to; ++i)
+			entries_[i] = entries_[i + 1];
+	else
+		for(::std::size_t i = from; i > to; --i)
+			entries_[i] = entries_[i - 1];
+	entries_[to] = entry;
+
+	++changes_;
+	dirty_ = true;
+}
+
+void XLib_StackingList::insert(ClientHandle handle, Window window, StackLayer layer)
+{
+	entries_.insert(entries_.begin() + layerEnd(layer), Entry{ handle, window, layer });
+	++changes_;
+	dirty_ = true;
+}
+
+/*-------------------------------------------------------------------
+ * Function: remove
+ * - the rest keep their relative order, nothing to restack.
+ *-------------------------------------------------------------------*/
+void XLib_StackingList::remove(ClientHandle handle)
+{
+	const ::std::size_t index = find(handle);
+	if(index < entries_.size())
+		entries_.erase(entries_.begin() + index);
+}
+
+void XLib_StackingList::raise(ClientHandle handle)
+{
+	const ::std::size_t index = find(handle);
+	if(index < entries_.size())
+		move(index, layerEnd(entries_[index].layer_) - 1);
+}
+
+void XLib_StackingList::lower(ClientHandle handle)
+{
+	const ::std::size_t index = find(handle);
+	if(index == entries_.size())
+		return;
+
+	// the bottom of the layer is just above the end of the layer below
+	::std::size_t begin = 0;
+	while(entries_[begin].layer_ < entries_[index].layer_)
+		++begin;
+	move(index, begin);
+}
+
+void XLib_StackingList::setLayer(ClientHandle handle, StackLayer layer)
+{
+	const ::std::size_t index = find(handle);
+	if(index == entries_.size())
+		return;
+	if(entries_[index].layer_ == layer)
+	{
+		raise(handle);
+		return;
+	}
+
+	Entry entry = entries_[index];
+	entries_.erase(entries_.begin() + index);
+	entry.layer_ = layer;
+	entries_.insert(entries_.begin() + layerEnd(layer), entry);
+	++changes_;
+	dirty_ = true;
+}
+
+/*-------------------------------------------------------------------
+ * Function: restore
+ * - linear in saved for each entry, only used to undo an Alt+Tab.
+ * - an entry's window and layer are the current ones; a client that
+ *   changed layer since is moved back into it by the sort.
+ *-------------------------------------------------------------------*/
+void XLib_StackingList::restore(const ::std::vector<Entry>& saved)
+{
+	::std::vector<Entry> order;
+	order.reserve(entries_.size());
+	for(const Entry& entry : saved)
+	{
+		const ::std::size_t index = find(entry.handle_);
+		if(index < entries_.size())
+			order.push_back(entries_[index]);
+	}
+	for(const Entry& entry : entries_)
+	{
+		const bool was_saved = ::std::any_of(saved.begin(), saved.end(),
+			[&entry](const Entry& other) { return other.handle_ == entry.handle_; });
+		if(!was_saved)
+			order.push_back(entry);
+	}
+	::std::stable_sort(order.begin(), order.end(),
+		[](const Entry& a, const Entry& b) { return a.layer_ < b.layer_; });
+
+	const bool same = ::std::equal(order.begin(), order.end(), entries_.begin(),
+		[](const Entry& a, const Entry& b) { return a.handle_ == b.handle_; });
+	if(same)
+	{
+		++redundant_;
+		return;
+	}
+	entries_.swap(order);
+	++changes_;
+	dirty_ = true;
+}
+
+const XLib_StackingList::Entry* XLib_StackingList::top() const
+{
+	return entries_.empty() ? nullptr : &entries_.back();
+}
+
+/*-------------------------------------------------------------------
+ * Function: restack
+ * - XRestackWindows wants the windows top first; it keeps the first
+ *   one where it is and stacks the others below it in turn. So the top
+ *   entry is raised first, above windows the WM does not manage and
+ *   from wherever a recycled border was left.
+ *-------------------------------------------------------------------*/
+void XLib_StackingList::restack(Display* display_)
+{
+	if(!dirty_)
+		return;
+	dirty_ = false;
+	if(entries_.empty())
+		return;
+
+	XRaiseWindow(display_, entries_.back().window_);
+	++restacks_;
+	if(entries_.size() < 2)
+		return;
+
+	restack_buffer_.resize(entries_.size());
+	for(::std::size_t i = 0; i < entries_.size(); ++i)
+		restack_buffer_[i] = entries_[entries_.size() - 1 - i].window_;
+	XRestackWindows(display_, restack_buffer_.data(), restack_buffer_.size());
+}
+
+::std::string XLib_StackingList::toString() const
+{
+	::std::ostringstream out;
+	out << "StackingList {windows: " << entries_.size()
+		<< ", changes: " << changes_
+		<< ", redundant: " << redundant_
+		<< ", restacks: " << restacks_ << " }";
+	return out.str();
+}
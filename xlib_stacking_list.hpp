@@ -0,0 +1,101 @@
+#ifndef XLIB_STACKING_LIST_HPP
+#define XLIB_STACKING_LIST_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "xlib_client_registry.hpp"
+
+/*-----------------------------------------------
+ * Enum: StackLayer
+ * - bottom to top; a window is always above every window of a lower
+ *   layer.
+ *-----------------------------------------------*/
+enum class StackLayer : uint8_t
+{
+	Normal,
+	KeepAbove,	// (Above is an X.h macro)
+	Dock,
+	Fullscreen
+};
+
+/*-----------------------------------------------
+ * Class: XLib_StackingList
+ * - the WM's stacking order of its clients' border windows, bottom to
+ *   top, grouped by layer.
+ * - raise/lower/insert/remove only change the list; restack() raises
+ *   the top window and sends the whole order as one XRestackWindows,
+ *   and only if it changed since the last one. Raising the window
+ *   already on top of its layer is free, so repeated raises (e.g. every
+ *   drag) cost nothing.
+ *-----------------------------------------------*/
+class XLib_StackingList
+{
+public:
+	struct Entry
+	{
+		ClientHandle handle_;
+		Window window_;		// the client's border window
+		StackLayer layer_;
+	};
+
+	XLib_StackingList();
+
+	/** Function: insert
+	 * - on top of its layer (a newly mapped client).
+	 **/
+	void insert(ClientHandle handle, Window window, StackLayer layer = StackLayer::Normal);
+	void remove(ClientHandle handle);
+
+	void raise(ClientHandle handle);
+	void lower(ClientHandle handle);
+	/** Function: setLayer
+	 * - moves handle to the top of layer.
+	 **/
+	void setLayer(ClientHandle handle, StackLayer layer);
+	/** Function: restore
+	 * - goes back to an order saved from entries(); clients added since
+	 *   stay on top of their layer, removed ones are skipped.
+	 **/
+	void restore(const ::std::vector<Entry>& saved);
+
+	/** Function: entries
+	 * - bottom to top.
+	 **/
+	const ::std::vector<Entry>& entries() const { return entries_; }
+	::std::size_t size() const { return entries_.size(); }
+	/** Function: top
+	 * - the top most client, or nullptr if there is none.
+	 **/
+	const Entry* top() const;
+	bool dirty() const { return dirty_; }
+
+	/** Function: restack
+	 * - pushes the order to the server if it changed.
+	 **/
+	void restack(Display* display_);
+
+	::std::string toString() const;
+
+private:
+	// index of handle in entries_, size() if missing
+	::std::size_t find(ClientHandle handle) const;
+	// where an entry of layer goes to be on top of it
+	::std::size_t layerEnd(StackLayer layer) const;
+	void move(::std::size_t from, ::std::size_t to);
+
+	::std::vector<Entry> entries_;
+	::std::vector<Window> restack_buffer_;
+	bool dirty_;
+
+	uint64_t restacks_;
+	uint64_t changes_;
+	uint64_t redundant_;
+};
+
+#endif
@@ -1,14 +1,31 @@
 #include "xlib_window.hpp"
 
+/*-------------------------------------------------------------------
+ * Constructor
+ * - kept cheap, xlib_window_id is assigned by XLib_ClientRegistry
+ *-------------------------------------------------------------------*/
 XLib_Window::XLib_Window()
 {
-	auto end = std::chrono::system_clock::now();
-	std::time_t time = std::chrono::system_clock::to_time_t(end);
-	
-	::std::stringstream ss;
-	ss << "XLib_Window[" << std::ctime(&time) << rand() % 10000;
-
-	xlib_window_id = ss.str(); 
+	single_window_ = false;
+
+	// createDecorations reads border_width_ before frameWindow runs
+	// (decoration pool prefill), so give every field its framing value
+	window_properties_.window_position_ = Position<int>(0, 0);
+	window_properties_.window_size_ = Size<int>(0, 0);
+	window_properties_.border_width_ = 1;
+	window_properties_.window_bar_height_ = 15;
+
+	sync_.checked_ = false;
+	sync_.counter_ = None;
+	sync_.alarm_ = None;
+	sync_.value_ = 0;
+	damage_.border_ = false;
+	damage_.move_button_ = false;
+	damage_.resize_button_ = false;
+	damage_.close_button_ = false;
+	mru_.linked_ = false;
+	mru_.prev_ = NO_CLIENT;
+	mru_.next_ = NO_CLIENT;
 }
 
 XLib_Window::~XLib_Window()
@@ -16,33 +33,145 @@ XLib_Window::~XLib_Window()
 
 }
 
-void XLib_Window::frameWindow(Display* display_, Window root_, Window w)
+/*-------------------------------------------------------------------
+ * Function: frameWindow
+ * - synchronous version, queries the client's geometry and name itself.
+ *-------------------------------------------------------------------*/
+void XLib_Window::frameWindow(Display* display_, Window root_, Window w, XLib_Resources& resources_)
 {
+	TRACE_SPAN("XLib_Window::frameWindow(query)");
 /** getting attributes of application window **/
 	XWindowAttributes x_window_attrs;
-	CHECK(XGetWindowAttributes(display_, w, &x_window_attrs));
-	// generating colourmap for windows
-	int screen = DefaultScreen(display_);
-	Colormap colormap = DefaultColormap(display_, screen);
-/** Defining Colours of Window **/
-	// bar_colour
-	XColor background_colour_;
-	background_colour_.red = 45000; background_colour_.green = 45000; background_colour_.blue = 45000;
-	background_colour_.flags = DoRed | DoGreen | DoBlue;
-	
-	// Allocating colour to display_
-	XAllocColor(display_, colormap, &background_colour_); 
+	{
+		TRACE_SPAN("XGetWindowAttributes");
+		CHECK(X_ROUND_TRIP(XGetWindowAttributes(display_, w, &x_window_attrs)));
+	}
+
+	XLib_ClientInfo info;
+	info.position_ = Position<int>(x_window_attrs.x, x_window_attrs.y);
+	info.size_ = Size<int>(x_window_attrs.width, x_window_attrs.height);
 
+	char* name = NULL;
+	if(X_ROUND_TRIP(XFetchName(display_, w, &name)) == 0)
+		info.name_ = "Window";
+	else
+	{
+		info.name_ = name;
+		XFree(name);
+	}
+
+	frameWindow(display_, root_, w, info, resources_);
+}
+
+/*-------------------------------------------------------------------
+ * Function: frameWindow
+ * - frames w using already fetched info (see WindowManager's startup
+ *   adoption, which fetches it for every window up front).
+ *-------------------------------------------------------------------*/
+void XLib_Window::frameWindow(Display* display_, Window root_, Window w, 
+	const XLib_ClientInfo& info, XLib_Resources& resources_)
+{
+	TRACE_SPAN("XLib_Window::frameWindow");
 /** Defining frame_ **/
 	application_window_ = w;
-	window_properties_.window_position_.x 	= x_window_attrs.x;
-	window_properties_.window_position_.y 	= x_window_attrs.y;
-	window_properties_.window_size_.height 	= x_window_attrs.height;
-	window_properties_.window_size_.width 	= x_window_attrs.width;
+	window_properties_.window_position_ 	= info.position_;
+	window_properties_.window_size_ 		= info.size_;
 	window_properties_.border_width_		= 1;
 	window_properties_.window_bar_height_	= 15;
 
-	// Setting window basic attributes
+/** creating window **/
+	border_.border_properties_.window_name_ = info.name_;
+	createWindow(display_, root_, resources_);
+}
+
+/*-------------------------------------------------------------------
+ * Function: resizeWindow / moveWindow
+ * - window_properties_ is the WM's authoritative geometry (border
+ *   position on the root, client size), kept in step with every
+ *   request so nothing has to ask the server for it.
+ *-------------------------------------------------------------------*/
+void XLib_Window::resizeWindow(Display* display_, unsigned int width, unsigned int height, Window root_)
+{
+	TRACE_SPAN("XLib_Window::resizeWindow");
+	XResizeWindow(display_, frame_, width, height);
+	XResizeWindow(display_, border_.border_window_, width, height+border_.border_height);
+	XResizeWindow(display_,	application_window_, width, height);
+
+	setSize(width, height);
+}
+void XLib_Window::moveWindow(Display* display_, unsigned int x, unsigned int y, Window root_)
+{
+	TRACE_SPAN("XLib_Window::moveWindow");
+	XMoveWindow(display_, border_.border_window_, x, y);
+
+	window_properties_.window_position_ = Position<int>(x, y);
+}
+
+void XLib_Window::setSize(unsigned int width, unsigned int height)
+{
+	window_properties_.window_size_ = Size<int>(width, height);
+	border_.border_properties_.border_size_ = Size<int>(width, height);
+
+	// painted buttons follow the size, the resize exposes the whole border
+	if(single_window_)
+		layoutButtons();
+}
+
+/*-------------------------------------------------------------------
+ * Function: layoutButtons
+ * - places the buttons at the right end of the title bar.
+ *-------------------------------------------------------------------*/
+void XLib_Window::layoutButtons()
+{
+	const unsigned int button_size_ = 8;
+	const unsigned int button_margin_ = 5;
+	const unsigned int button_colours_[] = { 0x00ff00, 0x0000ff, 0xff0000 };
+
+	XLib_Button* buttons[] = { &move_button_, &resize_button_, &close_button_ };
+	for(unsigned int i = 0; i < 3; ++i)
+	{
+		XLib_Button* button = buttons[i];
+		button->button_properties_.button_size_.width = button_size_;
+		button->button_properties_.button_size_.height = button_size_;
+		button->button_properties_.button_position_.x = 
+			window_properties_.window_size_.width - (button_size_ + button_margin_) * (i + 1);
+		button->button_properties_.button_position_.y = button_margin_;
+		button->button_properties_.button_colour_ = button_colours_[i];
+	}
+}
+
+XLib_Button* XLib_Window::hitTest(int x, int y)
+{
+	XLib_Button* buttons[] = { &move_button_, &resize_button_, &close_button_ };
+	for(XLib_Button* button: buttons)
+	{
+		if(button->contains(x, y))
+			return button;
+	}
+	return nullptr;
+}
+
+
+/*-------------------------------------------------------------------
+ * Function: createDecorations
+ * - creates (and grabs) the frame, border and button windows, at a
+ *   placeholder geometry; createWindow lays them out for the client.
+ * - the result can be recycled through XLib_DecorationPool, so nothing
+ *   here may depend on the client.
+ *-------------------------------------------------------------------*/
+void XLib_Window::createDecorations(Display* display_, const Window root_, XLib_Resources& resources_)
+{
+	TRACE_SPAN("XLib_Window::createDecorations");
+	/* Create Border Window */
+	border_.border_properties_.border_size_ = Size<int>(1, 1);
+	border_.border_properties_.border_position_ = Position<int>(0, 0);
+	border_.border_properties_.background_colour_ = 0;
+	border_.border_properties_.border_colour_ = 0;
+
+	border_.createWindow(display_, root_, resources_);
+
+	/* Create Frame Window */
+	// bar_colour (grey), resolved once for every frame
 	XSetWindowAttributes attrs_;
 
 	attrs_.event_mask = SubstructureRedirectMask| //handle child window requests (MapRequest)
@@ -51,54 +180,67 @@ void XLib_Window::frameWindow(Display* display_, Window root_, Window w)
 						ExposureMask			; //handle container redraw (Expose)
 
 	attrs_.do_not_propagate_mask = 0; // dont hide events from child window
-	attrs_.background_pixel = background_colour_.pixel; // background colour
+	attrs_.background_pixel = resources_.colour_cache_.pixel(display_, 45000, 45000, 45000);
 
 	unsigned long attrs_mask_ = CWEventMask  | // enable attrs.event_mask
 								NoEventMask  | // enable attrs.do_not_propagate_mask
 								CWBackPixel ; // enable attrs.background_pixel
 
-	window_properties_.attrs_mask_ = attrs_mask_;
-	window_properties_.set_attrs = attrs_;
-
-/** creating window **/
-	createWindow(display_, root_);
-
-	// b. resize windows with the alt+right button
-	XGrabButton(
-			display_,
-			Button1,
-			None,
-			resize_button_.button_window_,
-			false,
-			ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
-			GrabModeAsync,
-			GrabModeAsync,
-			None,
-			None);
-
-	XGrabButton(
-			display_,
-			Button1,
-			None,
-			move_button_.button_window_,
-			false,
-			ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
-			GrabModeAsync,
-			GrabModeAsync,
-			None,
-			None);
+	frame_ = XCreateWindow(
+		display_,
+		root_,
+		0, 0, 1, 1,
+		window_properties_.border_width_, 
+		CopyFromParent, // depth
+		InputOutput,	// class
+		CopyFromParent, // visual
+		attrs_mask_,	
+		&attrs_);
+	XReparentWindow(display_, frame_, border_.border_window_, 0, 0);
 
-	XGrabButton(
-			display_,
-			Button1,
-			None,
-			close_button_.button_window_,
-			false,
-			ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
-			GrabModeAsync,
-			GrabModeAsync,
-			None,
-			None);
+	// b. move, resize and close with button 1 on the buttons
+	if(single_window_)
+	{
+		// the border takes the clicks itself (the press grabs the pointer
+		// for the drag) and the WM hit tests them against the buttons
+		move_button_.button_window_ = None;
+		resize_button_.button_window_ = None;
+		close_button_.button_window_ = None;
+
+		XSelectInput(display_, border_.border_window_, 
+			SubstructureRedirectMask | SubstructureNotifyMask | ExposureMask |
+			ButtonPressMask | ButtonReleaseMask | ButtonMotionMask);
+	}
+	else
+	{
+		/* Create Button Windows */
+		move_button_.createWindow(display_, border_.border_window_);
+		resize_button_.createWindow(display_, border_.border_window_);
+		close_button_.createWindow(display_, border_.border_window_);
+
+		XSelectInput(display_, border_.border_window_, SubstructureRedirectMask | SubstructureNotifyMask | ExposureMask);
+
+		const Window buttons[] = {
+			move_button_.button_window_, 
+			resize_button_.button_window_, 
+			close_button_.button_window_ };
+		for(Window button: buttons)
+		{
+			XSelectInput(display_, button, ExposureMask);
+			XGrabButton(
+				display_,
+				Button1,
+				None,
+				button,
+				false,
+				ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
+				GrabModeAsync,
+				GrabModeAsync,
+				None,
+				None);
+			XMapWindow(display_, button);
+		}
+	}
 	
 	// c. kill windows with the alt+f4 button
 	XGrabKey(
@@ -119,107 +261,165 @@ void XLib_Window::frameWindow(Display* display_, Window root_, Window w)
 			false,
 			GrabModeAsync,
 			GrabModeAsync);
+
+	// children stay mapped for the life of the set, only the border is 
+	// mapped and unmapped with the client
+	XMapWindow(display_, frame_);
 }
 
-void XLib_Window::resizeWindow(Display* display_, unsigned int width, unsigned int height, Window root_)
+/*-------------------------------------------------------------------
+ * Function: decorations / useDecorations
+ *-------------------------------------------------------------------*/
+XLib_DecorationSet XLib_Window::decorations() const
 {
-	XResizeWindow(display_, frame_, width, height);
-	XResizeWindow(display_, border_.border_window_, width, height+window_properties_.window_bar_height_);
-	XResizeWindow(display_,	application_window_, width, height);
+	return XLib_DecorationSet{ 
+		frame_, 
+		border_.border_window_, 
+		move_button_.button_window_, 
+		resize_button_.button_window_, 
+		close_button_.button_window_ };
 }
-void XLib_Window::moveWindow(Display* display_, unsigned int x, unsigned int y, Window root_)
+
+void XLib_Window::useDecorations(const XLib_DecorationSet& set)
 {
-	XMoveWindow(display_, border_.border_window_, x, y);
+	frame_ = set.frame_;
+	border_.border_window_ = set.border_window_;
+	move_button_.button_window_ = set.move_button_;
+	resize_button_.button_window_ = set.resize_button_;
+	close_button_.button_window_ = set.close_button_;
 }
 
-
-void XLib_Window::createWindow(Display* display_, const Window root_)
+void XLib_Window::createWindow(Display* display_, const Window root_, XLib_Resources& resources_)
 {
-	/* Create Frame Window */
-	frame_ = XCreateWindow(
-		display_,
-		root_,
-		window_properties_.window_position_.x,
-		window_properties_.window_position_.y,
-		window_properties_.window_size_.width,
-		window_properties_.window_size_.height,
-		window_properties_.border_width_, 
-		CopyFromParent, // depth
-		InputOutput,	// class
-		CopyFromParent, // visual
-		window_properties_.attrs_mask_,	
-		&window_properties_.set_attrs);
-
-	/* Create Border Window */
-	border_.border_properties_.border_size_.width = window_properties_.window_size_.width;
-	border_.border_properties_.border_size_.height = window_properties_.window_size_.height;
-	border_.border_properties_.border_position_.x = window_properties_.window_position_.x;
-	border_.border_properties_.border_position_.y = window_properties_.window_position_.y;
-	border_.border_properties_.background_colour_ = 0;
-	border_.border_properties_.border_colour_ = 0;
-
-	char* name = NULL;
-	if(XFetchName(display_, application_window_, &name) == 0)
-		border_.border_properties_.window_name_ = "Window";
+	TRACE_SPAN("XLib_Window::createWindow");
+	/* Decorations, recycled if the pool has a set */
+	XLib_DecorationSet set;
+	if(resources_.decoration_pool_.take(set))
+		useDecorations(set);
 	else
-		border_.border_properties_.window_name_ = name;
+		createDecorations(display_, root_, resources_);
 
-	border_.createWindow(display_, root_);
-	
-	const unsigned int button_size_ = 8;
+	border_.depth_ = resources_.colour_cache_.argbVisual(display_, root_).depth;
+	move_button_.depth_ = border_.depth_;
+	resize_button_.depth_ = border_.depth_;
+	close_button_.depth_ = border_.depth_;
 
-	/* Create Move Button Window */
-	move_button_.button_properties_.button_size_.width = button_size_;
-	move_button_.button_properties_.button_size_.height = button_size_;
-	move_button_.button_properties_.button_position_.x = 
-		window_properties_.window_size_.width - button_size_ - 5;
-	move_button_.button_properties_.button_position_.y = 5;
-	move_button_.button_properties_.button_colour_ = 0x00ff00;
+	/* Border Geometry */
+	border_.border_properties_.border_size_ = window_properties_.window_size_;
+	border_.border_properties_.border_position_ = window_properties_.window_position_;
 
-	move_button_.createWindow(display_, border_.border_window_); // was root_ ???/
-
-	/* Create Resize Button Window */
-	resize_button_.button_properties_.button_size_.width = button_size_;
-	resize_button_.button_properties_.button_size_.height = button_size_;
-	resize_button_.button_properties_.button_position_.x = 
-		window_properties_.window_size_.width - (button_size_*2) - (5*2);
-	resize_button_.button_properties_.button_position_.y = 5;
-	resize_button_.button_properties_.button_colour_ = 0x0000ff;
-
-	resize_button_.createWindow(display_, border_.border_window_);
-
-	/* Create Close Button Window */
-	close_button_.button_properties_.button_size_.width = button_size_;
-	close_button_.button_properties_.button_size_.height = button_size_;
-	close_button_.button_properties_.button_position_.x = 
-		window_properties_.window_size_.width - (button_size_*3) - (5*3);
-	close_button_.button_properties_.button_position_.y = 5;
-	close_button_.button_properties_.button_colour_ = 0xff0000;
-
-	close_button_.createWindow(display_, border_.border_window_);
+	XMoveResizeWindow(display_, border_.border_window_,
+		window_properties_.window_position_.x,
+		window_properties_.window_position_.y,
+		window_properties_.window_size_.width,
+		window_properties_.window_size_.height + border_.border_height);
+	
+	/* Frame Geometry, below the title bar */
+	XMoveResizeWindow(display_, frame_, 0, border_.border_height,
+		window_properties_.window_size_.width,
+		window_properties_.window_size_.height);
+
+	layoutButtons();
+	if(!single_window_)
+	{
+		XLib_Button* buttons[] = { &move_button_, &resize_button_, &close_button_ };
+		for(XLib_Button* button: buttons)
+		{
+			XMoveResizeWindow(display_, button->button_window_,
+				button->button_properties_.button_position_.x,
+				button->button_properties_.button_position_.y,
+				button->button_properties_.button_size_.width,
+				button->button_properties_.button_size_.height);
+		}
+	}
 
 	/* Arrange Windows */
-
 	XReparentWindow(display_, application_window_, frame_, 0, 0);
-	XReparentWindow(display_, frame_, border_.border_window_, 0, 0);
-	
-	XMoveWindow(display_, frame_, window_properties_.window_position_.x, 
-		window_properties_.window_position_.y + border_.border_height);
-
-	XSelectInput(display_, border_.border_window_, SubstructureRedirectMask | SubstructureNotifyMask);		     
 
 	XAddToSaveSet(display_, application_window_);
 
 	XMapWindow(display_, border_.border_window_);
-	XMapWindow(display_, move_button_.button_window_);
-	XMapWindow(display_, resize_button_.button_window_);
-	XMapWindow(display_, close_button_.button_window_);
-	XMapWindow(display_, frame_);
 
-	border_.createRectangles(display_, root_);
-	close_button_.createRectangles(display_, root_);
-	move_button_.createRectangles(display_, root_);
-	resize_button_.createRectangles(display_, root_);
+	damage_.border_area_ = XRectangle{ 0, 0, 
+		static_cast<unsigned short>(window_properties_.window_size_.width), 
+		static_cast<unsigned short>(border_.border_height) };
+	damage_.border_ = true;
+	damage_.move_button_ = true;
+	damage_.resize_button_ = true;
+	damage_.close_button_ = true;
+	repaintDamage(display_, root_, resources_);
+}
+
+/*-------------------------------------------------------------------
+ * Function: addDamage
+ * - marks the decoration window w as needing a repaint, merging area
+ *   into the border's damaged rectangle.
+ *-------------------------------------------------------------------*/
+void XLib_Window::addDamage(Window w, const XRectangle& area)
+{
+	if(w == border_.border_window_)
+	{
+		if(!damage_.border_)
+		{
+			damage_.border_area_ = area;
+			damage_.border_ = true;
+			return;
+		}
+		XRectangle& merged = damage_.border_area_;
+		const int x1 = ::std::min<int>(merged.x, area.x);
+		const int y1 = ::std::min<int>(merged.y, area.y);
+		const int x2 = ::std::max<int>(merged.x + merged.width, area.x + area.width);
+		const int y2 = ::std::max<int>(merged.y + merged.height, area.y + area.height);
+		merged.x = x1;
+		merged.y = y1;
+		merged.width = x2 - x1;
+		merged.height = y2 - y1;
+	}
+	else if(w == move_button_.button_window_)
+		damage_.move_button_ = true;
+	else if(w == resize_button_.button_window_)
+		damage_.resize_button_ = true;
+	else if(w == close_button_.button_window_)
+		damage_.close_button_ = true;
+}
+
+/*-------------------------------------------------------------------
+ * Function: repaintDamage
+ * - repaints only the damaged decorations. The border is only drawn
+ *   on in the title bar, so damage below it needs no repaint (the
+ *   server already cleared it to the background pixel).
+ *-------------------------------------------------------------------*/
+void XLib_Window::repaintDamage(Display* display_, Window root_, XLib_Resources& resources_)
+{
+	TRACE_SPAN("XLib_Window::repaintDamage");
+	const bool bar_damaged = 
+		damage_.border_ && damage_.border_area_.y < static_cast<int>(border_.border_height);
+	if(bar_damaged)
+		border_.createRectangles(display_, root_, resources_);
+
+	if(single_window_)
+	{
+		if(bar_damaged)
+		{
+			move_button_.paintOn(display_, root_, border_.border_window_, resources_);
+			resize_button_.paintOn(display_, root_, border_.border_window_, resources_);
+			close_button_.paintOn(display_, root_, border_.border_window_, resources_);
+		}
+	}
+	else
+	{
+		if(damage_.move_button_)
+			move_button_.createRectangles(display_, root_, resources_);
+		if(damage_.resize_button_)
+			resize_button_.createRectangles(display_, root_, resources_);
+		if(damage_.close_button_)
+			close_button_.createRectangles(display_, root_, resources_);
+	}
+
+	damage_.border_ = false;
+	damage_.move_button_ = false;
+	damage_.resize_button_ = false;
+	damage_.close_button_ = false;
 }
 
 ::std::string XLib_Window::toString()
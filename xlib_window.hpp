@@ -4,8 +4,10 @@
 extern "C" { 
 #include <X11/Xlib.h> 
 #include <X11/Xutil.h>
+#include <X11/extensions/sync.h>
 }
 
+#include <cstdint>
 #include <sstream>
 #include <ctime>
 #include <chrono>
@@ -16,8 +18,22 @@ extern "C" {
 #include <mutex>
 #include <glog/logging.h>
 #include "util.hpp"
+#include "client_handle.hpp"
 #include "xlib_border.hpp"
 #include "xlib_button.hpp"
+#include "xlib_resources.hpp"
+#include "span_tracer.hpp"
+
+/*-----------------------------------------------
+ * Struct: XLib_ClientInfo
+ * - what framing needs to know about an application window.
+ *-----------------------------------------------*/
+struct XLib_ClientInfo
+{
+	Position<int> position_;
+	Size<int> size_;
+	::std::string name_;
+};
 
 class XLib_Window 
 {
@@ -34,23 +50,82 @@ public:
 	XLib_Button resize_button_;
 	XLib_Button close_button_;
 
+	/** 
+	 * Single window decorations: the buttons have no windows of their
+	 * own, they are painted into border_ and found with hitTest(). 
+	 * Set before frameWindow(). **/
+	bool single_window_;
+
 	struct 
 	{
 		Position<int> window_position_;
 		Size<int> window_size_;
 		unsigned int border_width_;
 		unsigned int window_bar_height_;
-		unsigned long attrs_mask_;
-		XSetWindowAttributes set_attrs;
 	}window_properties_;
 
+	/**
+	 * Decorations waiting on a repaint, set from Expose events and
+	 * cleared by repaintDamage() **/
+	struct
+	{
+		bool border_;
+		bool move_button_;
+		bool resize_button_;
+		bool close_button_;
+		XRectangle border_area_; // union of the border's exposed rectangles
+	}damage_;
+
+	/**
+	 * _NET_WM_SYNC_REQUEST state, looked up the first time the client is
+	 * resized interactively. counter_ is None if the client does not
+	 * support the protocol. **/
+	struct
+	{
+		bool checked_;
+		XSyncCounter counter_;
+		XSyncAlarm alarm_;		// fires once counter_ reaches value_
+		uint64_t value_;		// last value requested from the client
+	}sync_;
+
+	/**
+	 * Links of the focus MRU list (XLib_MruList), towards the more and
+	 * the less recently focused client **/
+	struct
+	{
+		bool linked_;
+		ClientHandle prev_;
+		ClientHandle next_;
+	}mru_;
+
 	XLib_Window();
 	~XLib_Window();
 
-	void createWindow(Display* display_, const Window root_);
+	/** Function: createWindow
+	 * - decorates application_window_ at window_properties_, with a
+	 *   recycled decoration set when the pool has one.
+	 **/
+	void createWindow(Display* display_, const Window root_, XLib_Resources& resources_);
+	void createDecorations(Display* display_, const Window root_, XLib_Resources& resources_);
+	XLib_DecorationSet decorations() const;
+	/** Function: hitTest
+	 * - the painted button under (x, y) of border_, nullptr if none.
+	 **/
+	XLib_Button* hitTest(int x, int y);
+	void useDecorations(const XLib_DecorationSet& set);
 	void resizeWindow(Display* display_, unsigned int width, unsigned int height, Window root_);
 	void moveWindow(Display* display_, unsigned int x, unsigned int y, Window root_);
-	void frameWindow(Display* display_, Window root_, Window w);
+	/** Function: setSize
+	 * - updates the cached client size only (no requests).
+	 **/
+	void setSize(unsigned int width, unsigned int height);
+	void layoutButtons();
+	void frameWindow(Display* display_, Window root_, Window w, XLib_Resources& resources_);
+	void frameWindow(Display* display_, Window root_, Window w, 
+		const XLib_ClientInfo& info, XLib_Resources& resources_);
+
+	void addDamage(Window w, const XRectangle& area);
+	void repaintDamage(Display* display_, Window root_, XLib_Resources& resources_);
 
 	::std::string toString();
 };
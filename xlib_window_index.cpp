@@ -0,0 +1,110 @@
+#include "xlib_window_index.hpp"
+
+XLib_WindowIndex::XLib_WindowIndex(::std::size_t initial_capacity)
+	: size_(0)
+{
+	::std::size_t capacity = 8;
+	while(capacity < initial_capacity)
+		capacity <<= 1;
+
+	entries_.assign(capacity, WindowIndexEntry{ None, ClientHandle{ 0, 0 }, WindowRole::Application });
+	mask_ = capacity - 1;
+}
+
+/*-------------------------------------------------------------------
+ * Function: slotOf
+ * - XIDs of one client are sequential from its resource base, so a
+ *   fibonacci (multiplicative) hash spreads them across the table.
+ *-------------------------------------------------------------------*/
+::std::size_t XLib_WindowIndex::slotOf(Window w) const
+{
+	return static_cast<::std::size_t>((static_cast<uint64_t>(w) * 0x9E3779B97F4A7C15ull) >> 32) & mask_;
+}
+
+void XLib_WindowIndex::insert(Window w, ClientHandle handle, WindowRole role)
+{
+	if((size_ + 1) * 2 > entries_.size())
+		grow();
+
+	::std::size_t slot = slotOf(w);
+	while(entries_[slot].window_ != None && entries_[slot].window_ != w)
+		slot = (slot + 1) & mask_;
+
+	if(entries_[slot].window_ == None)
+		++size_;
+	entries_[slot] = WindowIndexEntry{ w, handle, role };
+}
+
+const WindowIndexEntry* XLib_WindowIndex::find(Window w) const
+{
+	if(w == None)
+		return nullptr;
+
+	::std::size_t slot = slotOf(w);
+	for(;;)
+	{
+		const WindowIndexEntry& entry = entries_[slot];
+		if(entry.window_ == w)
+			return &entry;
+		if(entry.window_ == None)
+			return nullptr;
+		slot = (slot + 1) & mask_;
+	}
+}
+
+/*-------------------------------------------------------------------
+ * Function: erase
+ * - backward shift deletion: every entry after the hole that would
+ *   still be reachable from its home slot through the hole moves up.
+ *-------------------------------------------------------------------*/
+bool XLib_WindowIndex::erase(Window w)
+{
+	if(w == None)
+		return false;
+
+	::std::size_t hole = slotOf(w);
+	while(entries_[hole].window_ != w)
+	{
+		if(entries_[hole].window_ == None)
+			return false;
+		hole = (hole + 1) & mask_;
+	}
+
+	::std::size_t next = (hole + 1) & mask_;
+	while(entries_[next].window_ != None)
+	{
+		const ::std::size_t home = slotOf(entries_[next].window_);
+		// distance travelled from home, compared to the hole's distance
+		if(((next - home) & mask_) >= ((next - hole) & mask_))
+		{
+			entries_[hole] = entries_[next];
+			hole = next;
+		}
+		next = (next + 1) & mask_;
+	}
+
+	entries_[hole].window_ = None;
+	--size_;
+	return true;
+}
+
+void XLib_WindowIndex::clear()
+{
+	for(auto& entry: entries_)
+		entry.window_ = None;
+	size_ = 0;
+}
+
+void XLib_WindowIndex::grow()
+{
+	::std::vector<WindowIndexEntry> old_entries;
+	old_entries.swap(entries_);
+
+	entries_.assign(old_entries.size() * 2, WindowIndexEntry{ None, ClientHandle{ 0, 0 }, WindowRole::Application });
+	mask_ = entries_.size() - 1;
+	size_ = 0;
+
+	for(const auto& entry: old_entries)
+		if(entry.window_ != None)
+			insert(entry.window_, entry.handle_, entry.role_);
+}
@@ -0,0 +1,70 @@
+#ifndef XLIB_WINDOW_INDEX_HPP
+#define XLIB_WINDOW_INDEX_HPP
+
+extern "C" {
+#include <X11/Xlib.h>
+}
+
+#include <cstdint>
+#include <vector>
+
+#include "xlib_client_registry.hpp"
+
+/*-----------------------------------------------
+ * Enum: WindowRole
+ * - which of a client's windows an X window id is.
+ *-----------------------------------------------*/
+enum class WindowRole : uint8_t
+{
+	Application,
+	Frame,
+	Border,
+	MoveButton,
+	ResizeButton,
+	CloseButton
+};
+
+/*-----------------------------------------------
+ * Struct: WindowIndexEntry
+ *-----------------------------------------------*/
+struct WindowIndexEntry
+{
+	Window window_; // None marks an empty slot
+	ClientHandle handle_;
+	WindowRole role_;
+};
+
+/*-----------------------------------------------
+ * Class: XLib_WindowIndex
+ * - maps every managed X window id (application, frame, border and
+ *   buttons) to its client handle and role.
+ * - open addressing with linear probing over one flat array, kept at
+ *   most half full, so a lookup is a single (usually one slot) probe.
+ * - erase() shifts the following entries back instead of leaving
+ *   tombstones, so probe lengths don't degrade with map/unmap churn.
+ *-----------------------------------------------*/
+class XLib_WindowIndex
+{
+public:
+	explicit XLib_WindowIndex(::std::size_t initial_capacity = 64);
+
+	void insert(Window w, ClientHandle handle, WindowRole role);
+	/** Function: find
+	 * - returns nullptr if w is not managed.
+	 **/
+	const WindowIndexEntry* find(Window w) const;
+	bool erase(Window w);
+
+	::std::size_t size() const { return size_; }
+	void clear();
+
+private:
+	::std::size_t slotOf(Window w) const;
+	void grow();
+
+	::std::vector<WindowIndexEntry> entries_;
+	::std::size_t mask_;
+	::std::size_t size_;
+};
+
+#endif